@@ -4,8 +4,24 @@ import time
 import enum
 import argparse
 import struct
+import zlib
+import threading
 
 pb_length = 40
+max_window = 16  # the sequence check only sees the low byte of the address
+max_resync = 5
+online_timeout = 15.0 # bring-up of a node after the reset, including the nickname
+prog_gap = 0.003     # time to write a put without acknowledge
+eedata_gap = 0.035
+crc_chunk = 0x8000
+row_size = 64        # program memory erase row
+crc_timeout = 2.0    # CRC32 of a chunk takes ~0.4s in the target
+chk_run_timeout = 10.0 # a bootloader with AB_SLOTS copies the image to its rollback slot first
+max_run = 66         # longest run or copy of a packed stream
+min_distance = 8     # a copy of a packed stream reads a write block that is done
+max_distance = 0xFFFF
+max_chain = 32       # earlier positions of a string that are tried for a copy
+eedata_run = 16      # EEDATA takes 4ms a byte, keeps a packed frame within the acknowledge timeout
 
 class msg(enum.Enum):
     put_cntrl = 0x1000
@@ -19,6 +35,8 @@ class cmd(enum.Enum):
     rst_chksm = 0x02       # Reset the checksum counter and verify status
     chk_run = 0x03         # Add checksum to special data, if verify and zero checksum
                            # then clear first location of EEDATA.
+    crc32 = 0x04           # Send the CRC32 of special data bytes from the pointer on
+    pack = 0x05            # Start a packed stream, written from the pointer on
            
 # Print iterations progress, from https://stackoverflow.com/questions/3173320/text-progress-bar-in-the-console
 def printProgressBar (iteration, total, prefix = '', suffix = '', decimals = 1, length = 100, fill = '█', printEnd = "\r"):
@@ -45,6 +63,18 @@ def printProgressBar (iteration, total, prefix = '', suffix = '', decimals = 1,
            
 class no_reply(Exception):
     pass
+
+class verify_error(Exception):
+    pass
+
+# Output of the workers of an inventory upgrade is prefixed with the
+# bus and node
+output = threading.local()
+output_lock = threading.Lock()
+
+def log(text=''):
+    with output_lock:
+        print(getattr(output, 'prefix', '') + text)
            
 def auto_int(x):
     return int(x, 0)
@@ -61,12 +91,12 @@ def segment(x):
     if x >= 0xf00000:
         return 'eedata'
            
-def send_msg(bus, msg_type, data=bytearray()):
+def send_msg(bus, msg_type, data=bytearray(), timeout=0.5):
     tx_msg = can.Message(arbitration_id=msg_type.value, data=data, is_extended_id=True)
     bus.send(tx_msg)
 
     while True:
-        rx_msg = bus.recv(0.5)
+        rx_msg = bus.recv(timeout)
         if rx_msg == None:            
             raise no_reply
         else:
@@ -75,9 +105,89 @@ def send_msg(bus, msg_type, data=bytearray()):
                 return rx_msg.data                
                 
 
-def control_reg(address=0x000000, write=False, cmd=cmd.nop, sp_data=0x0000):
-    def_flags = 0x1C #auto erase, auto inc, ack
+def drain(bus, timeout=0.05):
+    while bus.recv(timeout) != None:
+        pass
+
+def pointer(data):
+    return data[0] | (data[1] << 8) | (data[2] << 16)
+
+def read_pointer(bus):
+    drain(bus)
+    return pointer(send_msg(bus, msg.get_cntrl))
+
+def put_segment(bus, start, data, window, progress=None):
+    # Keep up to window puts outstanding. The bootloader drops a put out of
+    # sequence and acknowledges it with its pointer, so after a lost frame
+    # the stream is resumed from the pointer.
+    end = start + len(data)
+    address = start
+    acked = start
+    resync = 0
+    
+    while acked < end:
+        while address < end and address - acked < 8*window:
+            offset = address - start
+            tx_msg = can.Message(arbitration_id=msg.put_data.value | (address & 0xff), 
+                                 data=data[offset:offset+8], is_extended_id=True)
+            bus.send(tx_msg)
+            address += 8
+        
+        rx_msg = bus.recv(0.5)
+        if rx_msg != None and not (rx_msg.arbitration_id & 0x0100):
+            continue # control reply, not ours
+        if rx_msg != None and len(rx_msg.data) >= 3:
+            rv = pointer(rx_msg.data)
+            if acked < rv <= address:
+                acked = rv
+                resync = 0
+                if progress:
+                    progress(acked - start)
+                continue
+        
+        # lost frame or acknowledge, restart from the pointer in the target
+        resync += 1
+        if resync > max_resync:
+            raise no_reply
+        if rx_msg != None:
+            drain(bus)
+            rv = pointer(rx_msg.data) if len(rx_msg.data) >= 3 else read_pointer(bus)
+        else:
+            rv = read_pointer(bus)
+        if not start <= rv <= end:
+            raise no_reply
+        acked = address = rv
+
+def send_all(bus, msg_type, nodes, data=bytearray(), nickname=0, timeout=0.5, retries=0):
+    # Send to all nodes in boot mode, or to nickname only, and collect the
+    # replies of the nodes. Retries go to each missing node, only for
+    # control commands, a data command always goes to all nodes.
+    tx_msg = can.Message(arbitration_id=msg_type.value | nickname, data=data, is_extended_id=True)
+    bus.send(tx_msg)
+    
+    replies = {}
+    while len(replies) < len(nodes):
+        rx_msg = bus.recv(timeout)
+        if rx_msg == None:
+            break
+        node = rx_msg.arbitration_id & 0xff
+        if node in nodes and (rx_msg.arbitration_id & 0x0100) == (msg_type.value & 0x0100):
+            replies[node] = rx_msg.data
+    if nickname == 0:
+        drain(bus) # other nodes in boot mode answer a broadcast too
+    
+    for attempt in range(retries):
+        for n in nodes - replies.keys():
+            replies.update(send_all(bus, msg_type, {n}, data=data, nickname=n, timeout=timeout))
+    return replies
+
+def control_reg(address=0x000000, write=False, cmd=cmd.nop, sp_data=0x0000, seq=False, ack=True, mute=False, pack=False):
+    def_flags = 0x0C #auto erase, auto inc
+    ack_flag = 0x10
     write_flag = 0x01
+    seq_flag = 0x20
+    mute_flag = 0x40
+    pack_flag = 0x80
     rv = bytearray(8)
     rv[0] = address & 0xff
     rv[1] = (address & 0x00ff00) >> 8
@@ -86,12 +196,105 @@ def control_reg(address=0x000000, write=False, cmd=cmd.nop, sp_data=0x0000):
     rv[4] = def_flags
     if write:
         rv[4] |= write_flag
+    if seq:
+        rv[4] |= seq_flag
+    if ack:
+        rv[4] |= ack_flag
+    if mute:
+        rv[4] |= mute_flag
+    if pack:
+        rv[4] |= pack_flag
     rv[5] = cmd.value & 0xff
     rv[6] = sp_data & 0xff
     rv[7] = (sp_data & 0xff00) >> 8
     return rv
 
-def iter_hex(bus, ih, verify=False, progress=True):
+def pack_stream(data, longest=max_run, copies=True):
+    # The packed stream of CMD_PACK, a control byte c is followed by
+    #   0x00-0x7F  c+1 literal bytes
+    #   0x80-0xBF  one byte repeated c-0x7D times
+    #   0xC0-0xFF  a distance d (LSB first), c-0xBD bytes are copied from d back
+    # A copy reads flash that the target already wrote, so d is at least one
+    # write block and copies are only used in program memory.
+    rv = bytearray()
+    literal = bytearray()
+    seen = {}  # positions of each 3 byte string
+    i = 0
+    while i < len(data) or literal:
+        run = 1
+        while i + run < len(data) and run < longest and data[i + run] == data[i]:
+            run += 1
+        copy = 0
+        distance = 0
+        for j in reversed(seen.get(bytes(data[i:i+3]), [])[-max_chain:] if copies else []):
+            if i - j > max_distance:
+                break
+            if i - j < min_distance:
+                continue
+            n = 0
+            while i + n < len(data) and n < longest and data[j + n] == data[i + n]:
+                n += 1
+            if n > copy:
+                copy, distance = n, i - j
+        if i < len(data) and run < 3 and copy < 4:
+            seen.setdefault(bytes(data[i:i+3]), []).append(i)
+            literal.append(data[i])
+            i += 1
+            if len(literal) < 128:
+                continue
+        if literal:
+            rv.append(len(literal) - 1)
+            rv += literal
+            literal = bytearray()
+        if i >= len(data):
+            continue
+        if run >= 3 and run + 1 >= copy: # a run is a byte shorter than a copy
+            rv += bytes((run + 0x7D, data[i]))
+            n = run
+        elif copy >= 4:
+            rv += bytes((copy + 0xBD, distance & 0xff, distance >> 8))
+            n = copy
+        else:
+            continue
+        for j in range(i, i + n):
+            seen.setdefault(bytes(data[j:j+3]), []).append(j)
+        i += n
+    return rv
+
+def pack_written(packed):
+    # The bytes each frame of a packed stream writes in the target
+    written = []
+    count = 0
+    operands = 0
+    for offset in range(0, len(packed), 8):
+        n = 0
+        for c in packed[offset:offset+8]:
+            if operands:
+                operands -= 1
+                if not operands:
+                    n += count
+                    count = 0
+            elif count:
+                n += 1
+                count -= 1
+            elif c < 0x80:
+                count = c + 1
+            else:
+                count = (c & 0x3F) + 3
+                operands = 1 if c < 0xC0 else 2
+        written.append(n)
+    return written
+
+def packed(start, data):
+    if segment(start) == 'eedata':
+        return pack_stream(data, eedata_run, copies=False)
+    return pack_stream(data)
+
+def pack_supported(replies):
+    # ERRST bit 7 of a control get
+    return all(len(d) == 8 and d[3] & 0x80 for d in replies)
+
+def iter_hex(bus, ih, verify=False, progress=True, window=1, pack=False):
     data_buffer = bytearray(8)
     checksum = 0    
     
@@ -102,7 +305,18 @@ def iter_hex(bus, ih, verify=False, progress=True):
         end = ((end + 7)//8)*8
         segstring = '   segment {0:12}: 0x{1:06X}-0x{2:06X}'.format(segment(start), start, end)
         if not progress:
-            print(segstring)
+            log(segstring)
+        
+        if window > 1 and not verify:
+            data = bytearray(ih[i] for i in range(start, end))
+            checksum += sum(data)
+            if pack:
+                data = packed(start, data)
+            send_msg(bus, msg.put_cntrl, data=control_reg(address=start, write=True, seq=True, pack=pack,
+                                                          cmd=cmd.pack if pack else cmd.nop))
+            put_segment(bus, start, data, window, 
+                        lambda done: printProgressBar(done, len(data), prefix=segstring, length=pb_length) if progress else None)
+            continue
         
         send_msg(bus, msg.put_cntrl, data=control_reg(address=start, write=not(verify)))
         
@@ -116,19 +330,24 @@ def iter_hex(bus, ih, verify=False, progress=True):
                 if(verify):
                     rb = send_msg(bus, msg.get_data)
                     if rb != data_buffer:
-                        print('')
-                        print('Error during verification at 0x{:06X}'.format(i))
+                        log()
+                        log('Error during verification at 0x{:06X}'.format(i))
                         expected = ['{:02X} '.format(b) for b in data_buffer]
                         returned = ['{:02X} '.format(b) for b in rb]
-                        print('Expected {}, got {}.'.format(expected, returned))
-                        exit(0)
+                        log('Expected {}, got {}.'.format(expected, returned))
+                        raise verify_error
                 else:
-                    send_msg(bus, msg.put_data, data_buffer)
+                    # a put the bootloader can't write is acknowledged
+                    # with the unchanged pointer
+                    if pointer(send_msg(bus, msg.put_data, data_buffer)) != i + 1:
+                        log()
+                        log('Put at 0x{:06X} was not written'.format(i - 7))
+                        raise verify_error
             
            
     return checksum
     
-def eedata(bus, size, verify=False, progress=True):
+def eedata(bus, size, verify=False, progress=True, window=1, pack=False):
     data_buffer = bytearray(b'\xFF')*8
     checksum = 0
     
@@ -137,7 +356,17 @@ def eedata(bus, size, verify=False, progress=True):
     end = ((end + 7)//8)*8 # round to next multiple of 8    
     segstring = '   segment {0:12}: 0x{1:06X}-0x{2:06X}'.format(segment(start), start, end)
     if not progress:
-            print(segstring)
+            log(segstring)
+    
+    if window > 1 and not verify:
+        data = bytearray(b'\xFF')*(end-start)
+        if pack:
+            data = packed(start, data)
+        send_msg(bus, msg.put_cntrl, data=control_reg(address=start, write=True, seq=True, pack=pack,
+                                                      cmd=cmd.pack if pack else cmd.nop))
+        put_segment(bus, start, data, window,
+                    lambda done: printProgressBar(done, len(data), prefix=segstring, length=pb_length) if progress else None)
+        return 0xFF*(end-start)
     
     send_msg(bus, msg.put_cntrl, data=control_reg(address=start, write=not(verify)))
             
@@ -149,63 +378,619 @@ def eedata(bus, size, verify=False, progress=True):
             if verify:
                 rb = send_msg(bus, msg.get_data)
                 if rb != data_buffer:
-                    print('Error during EEPROM verification at 0x{:06X}'.format(i))
-                    exit(0)                
+                    log('Error during EEPROM verification at 0x{:06X}'.format(i))
+                    raise verify_error                
             else:
                 send_msg(bus, msg.put_data, data_buffer)     
             
     return checksum
 
-if __name__ == "__main__":
-    parser = argparse.ArgumentParser(description="Program a PIC controller on CAN bus using the VSCP CAN Bootloader. Please look at Python-Can documentation for CAN configuration.")
-    parser.add_argument('filename', help='Intel HEX file to be programmed')
-    parser.add_argument('-c', '--context', dest='context', default='default', help='CAN bus context to use from CAN config file')
-    parser.add_argument('-n', '--nick', dest='nickname', help='VSCP Nickname of node (default=0xFE)', default=0xFE, type=auto_int)
-    parser.add_argument('-P', '--noprogress', dest='progress', action='store_false', help='No progress indicators')
-    parser.add_argument('-V', '--noverify', dest='verify', action='store_false', help='No verification after writing')
-    parser.add_argument('-R', '--noreset', dest='reset', action='store_false', help='No reset when done')
-    parser.add_argument('-e', '--eedataerase', dest='ereedata', action='store_true', help='Erase EEDATA')
-    parser.add_argument('-s', '--eedatasize', dest='eedatasize', help='EEDATA size for erasing (default=0xFF)', default=0xFF, type=auto_int)
+def hex_segments(ih):
+    for start, end in ih.segments():
+        if segment(start) == 'config': # skip config space! don't overwrite values set by bootloader
+            continue
+        start = (start//8)*8
+        end = ((end + 7)//8)*8
+        yield start, bytearray(ih[i] for i in range(start, end))
+
+def eedata_segment(size):
+    return 0xf00000, bytearray(b'\xFF')*(((size + 7)//8)*8)
+
+def crc_check(bus, nodes, start, data):
+    # Compare the CRC32 of the nodes with the image. Returns the nodes with 
+    # another CRC and the nodes without the CRC32 command.
+    failed = set()
+    unsupported = set()
+    for offset in range(0, len(data), crc_chunk):
+        chunk = data[offset:offset+crc_chunk]
+        pending = nodes - failed - unsupported
+        if not pending:
+            break
+        rv = send_all(bus, msg.put_cntrl, pending, timeout=crc_timeout, retries=max_resync,
+                      data=control_reg(address=start+offset, cmd=cmd.crc32, sp_data=len(chunk)))
+        for n in pending:
+            if n not in rv:
+                failed.add(n)
+            elif len(rv[n]) != 4:
+                unsupported.add(n)
+            elif struct.unpack('<I', rv[n])[0] != zlib.crc32(chunk):
+                failed.add(n)
+    return failed, unsupported
+
+def image_rows(ih, eedatasize=None):
+    # The image in whole erase rows, bytes without data in the file are
+    # blank (0xFF)
+    rows = {}
+    for start, data in hex_segments(ih):
+        for row in range((start//row_size)*row_size, start + len(data), row_size):
+            rows[row] = bytearray(ih[i] for i in range(row, row + row_size))
+    if eedatasize != None:
+        start, data = eedata_segment(eedatasize)
+        for offset in range(0, len(data), row_size):
+            rows[start + offset] = data[offset:offset+row_size]
+    return sorted(rows.items())
+
+def changed_rows(bus, nodes, rows, progress=True):
+    # Keep the rows with another CRC32 in any of the nodes, None if a node
+    # has no CRC32 command
+    changed = []
+    for n, (start, data) in enumerate(rows):
+        failed, unsupported = crc_check(bus, nodes, start, data)
+        if unsupported:
+            return None
+        if failed:
+            changed.append((start, data))
+        if progress:
+            printProgressBar(n + 1, len(rows), prefix='   compare rows', length=pb_length)
+    log('   {} of {} rows changed'.format(len(changed), len(rows)))
+    return changed
+
+def put_rows(bus, rows, window, progress=True, pack=False):
+    for n, (start, data) in enumerate(rows):
+        send_msg(bus, msg.put_cntrl, data=control_reg(address=start, write=True, seq=window > 1, pack=pack,
+                                                      cmd=cmd.pack if pack else cmd.nop))
+        if pack:
+            put_segment(bus, start, packed(start, data), window)
+        elif window > 1:
+            put_segment(bus, start, data, window)
+        else:
+            for offset in range(0, len(data), 8):
+                send_msg(bus, msg.put_data, data[offset:offset+8])
+        if progress:
+            printProgressBar(n + 1, len(rows), prefix='   write rows', length=pb_length)
+    return sum(sum(data) for start, data in rows)
+
+def verify_crc(bus, nodes, segments):
+    failed = set()
+    unsupported = set()
+    for start, data in segments:
+        f, u = crc_check(bus, nodes - failed - unsupported, start, data)
+        log('   segment {0:12}: 0x{1:06X}-0x{2:06X} {3}'.format(segment(start), start, start + len(data), 
+                                                                  'CRC error' if f else 'CRC ok'))
+        failed |= f
+        unsupported |= u
+    return failed, unsupported
+
+def multicast_segment(bus, nodes, start, data, gap, progress=True, pack=False):
+    # Stream the segment to all nodes, then resend the missing part while
+    # the nodes make progress. A node drops the stream after a lost put, so
+    # all nodes are muted and each one is armed again when the stream 
+    # reaches its pointer. Returns the nodes that failed.
+    segstring = '   segment {0:12}: 0x{1:06X}-0x{2:06X}'.format(segment(start), start, start + len(data))
+    if not progress:
+        log(segstring)
+    
+    # A packed stream is sent the same way, the pointers of the nodes are
+    # positions in the stream. A frame gets the time of the bytes it writes.
+    gaps = [gap]*((len(data) + 7)//8)
+    if pack:
+        data = packed(start, data)
+        gaps = [gap*max(1, n//8) for n in pack_written(data)]
+    end = start + len(data)
+    
+    failed = set()
+    lagging = {n: start for n in nodes}
+    stalled = 0
+    
+    while lagging and stalled <= max_resync:
+        address = min(lagging.values())
+        if address != start:
+            log('   resend 0x{:06X}-0x{:06X} to {}'.format(address, end, ', '.join('0x{:02X}'.format(n) for n in sorted(lagging))))
         
-    args = parser.parse_args()
+        drain(bus)
+        rv = send_all(bus, msg.put_cntrl, lagging.keys(), data=control_reg(mute=True, ack=False), retries=max_resync)
+        failed |= lagging.keys() - rv.keys()
+        armed = set()
+        
+        for i in range(address, end, 8):
+            for n in [n for n, p in lagging.items() if p == i and n not in failed]:
+                if send_all(bus, msg.put_cntrl, {n}, data=control_reg(address=i, write=True, seq=True, ack=False, pack=pack,
+                                                                      cmd=cmd.pack if pack and i == start else cmd.nop), 
+                            nickname=n, retries=max_resync):
+                    armed.add(n)
+                else:
+                    failed.add(n)
+            offset = i - start
+            bus.send(can.Message(arbitration_id=msg.put_data.value | (i & 0xff), 
+                                 data=data[offset:offset+8], is_extended_id=True))
+            time.sleep(gaps[offset//8])
+            if progress:
+                printProgressBar(i + 8 - start, end - start, prefix=segstring, length=pb_length)
+        
+        rv = send_all(bus, msg.get_cntrl, armed, retries=max_resync)
+        failed |= armed - rv.keys()
+        stalled += 1
+        for n, d in rv.items():
+            if pointer(d) > lagging[n]:
+                stalled = 0
+            if pointer(d) == end:
+                del lagging[n]
+            elif start <= pointer(d) < end:
+                lagging[n] = pointer(d)
+            else:
+                failed.add(n)
+        for n in failed:
+            lagging.pop(n, None)
     
-    ih = intelhex.IntelHex(args.filename)  # this performs checks on the input file
-    bus = can.interface.Bus(context=args.context)
+    return failed | lagging.keys()
+
+def multicast_verify(bus, nodes, start, data, progress=True):
+    end = start + len(data)
+    segstring = '   segment {0:12}: 0x{1:06X}-0x{2:06X}'.format(segment(start), start, end)
+    if not progress:
+        log(segstring)
+    failed = set()
+    send_all(bus, msg.put_cntrl, nodes, data=control_reg(address=start), retries=max_resync)
+    
+    for i in range(start, end, 8):
+        offset = i - start
+        if progress:
+            printProgressBar(i + 8 - start, end - start, prefix=segstring, length=pb_length)
+        rv = send_all(bus, msg.get_data, nodes - failed)
+        for n in nodes - failed:
+            if rv.get(n) != data[offset:offset+8]:
+                log('Error during verification of 0x{:02X} at 0x{:06X}'.format(n, i))
+                failed.add(n)
     
-    filters = [{"can_id":   0x00001400 | args.nickname, 
+    return failed
+
+def multicast(bus, ih, nodes, args):
+    segments = list(hex_segments(ih))
+    if(args.ereedata):
+        segments.append(eedata_segment(args.eedatasize))
+    
+    rv = send_all(bus, msg.put_cntrl, nodes, data=control_reg(cmd=cmd.rst_chksm), retries=max_resync)
+    failed = nodes - rv.keys()
+    for n in sorted(failed):
+        log('Did not get a reply from 0x{:02X}, correct nickname?'.format(n))
+    
+    pack = False
+    if args.pack:
+        rv = send_all(bus, msg.get_cntrl, nodes - failed, retries=max_resync)
+        pack = rv.keys() == nodes - failed and pack_supported(rv.values())
+        if not pack:
+            log('Not all bootloaders take packed data, sending it plain')
+    
+    log('Program...')
+    written = segments
+    if(args.delta):
+        rows = changed_rows(bus, nodes - failed, image_rows(ih, args.eedatasize if args.ereedata else None), progress=args.progress)
+        if rows == None:
+            log('   bootloader has no CRC32, programming all')
+        else:
+            written = rows
+    checksum = sum(sum(data) for start, data in written)
+    checksum = (0xFFFF-(checksum & 0xFFFF)+1) & 0xFFFF
+    
+    for start, data in written:
+        gap = eedata_gap if segment(start) == 'eedata' else prog_gap
+        failed |= multicast_segment(bus, nodes - failed, start, data, gap, progress=args.progress, pack=pack)
+    
+    if(args.verify):
+        log('Verify...')
+        unsupported = nodes - failed
+        if not args.readback:
+            crc_failed, unsupported = verify_crc(bus, nodes - failed, segments)
+            failed |= crc_failed
+        if unsupported:
+            for start, data in segments:
+                failed |= multicast_verify(bus, unsupported - failed, start, data, progress=args.progress)
+    
+    # the running checksum of each node must match the image
+    rv = send_all(bus, msg.get_cntrl, nodes - failed, retries=max_resync)
+    for n in nodes - failed:
+        if n not in rv or ((rv[n][6] | (rv[n][7] << 8)) + checksum) & 0xFFFF:
+            log('Checksum error in 0x{:02X}'.format(n))
+            failed.add(n)
+    
+    log('Perform checksum check in targets...')
+    for n in sorted(nodes - failed):
+        send_all(bus, msg.put_cntrl, {n}, data=control_reg(cmd=cmd.chk_run, sp_data=checksum, write=True), nickname=n,
+                 timeout=chk_run_timeout, retries=max_resync)
+    
+    if(args.reset):
+        log('Resetting devices...')
+        for n in sorted(nodes - failed):
+            bus.send(can.Message(arbitration_id=msg.put_cntrl.value | n, data=control_reg(cmd=cmd.reset), is_extended_id=True))
+    
+    if failed:
+        log('Failed: {}'.format(', '.join('0x{:02X}'.format(n) for n in sorted(failed))))
+    else:
+        log('All {} nodes programmed'.format(len(nodes)))
+    return failed
+
+# VSCP level I protocol events, to get the nodes into the bootloader
+class vscp(enum.Enum):
+    new_node_online = 0x02
+    read_register = 0x09
+    rw_response = 0x0A
+    enter_boot_loader = 0x0C
+    nack_boot_loader = 0x0E
+    who_is_there = 0x1F
+    who_is_there_response = 0x20
+
+reg_boot_loader_algorithm = 0x97
+
+def vscp_send(bus, vscp_type, data):
+    # class 0, normal priority, sent by the segment controller (nickname 0)
+    bus.send(can.Message(arbitration_id=(3 << 26) | (vscp_type.value << 8), data=data, is_extended_id=True))
+
+def vscp_recv(bus, vscp_type, deadline, origin=None):
+    # next class 0 event of a type until the deadline, (nickname, data)
+    while True:
+        remaining = deadline - time.time()
+        if remaining <= 0:
+            return None, None
+        rx_msg = bus.recv(remaining)
+        if rx_msg == None:
+            return None, None
+        node = rx_msg.arbitration_id & 0xff
+        if ((rx_msg.arbitration_id >> 16) & 0x1ff) == 0 and \
+           ((rx_msg.arbitration_id >> 8) & 0xff) == vscp_type.value and \
+           origin in (None, node):
+            return node, rx_msg.data
+
+def who_is_there(bus, nickname=0xff, flush=True):
+    # {nickname: (guid, mdf)} of the nodes that answer, guid[i] is GUID 
+    # byte i. Broadcast replies are spread over 8ms per nickname.
+    bus.set_filters(None)
+    if flush:
+        drain(bus)
+    vscp_send(bus, vscp.who_is_there, [nickname])
+    deadline = time.time() + (2.5 if nickname == 0xff else 0.5)
+    
+    frames = {}
+    while True:
+        node, data = vscp_recv(bus, vscp.who_is_there_response, deadline)
+        if node == None:
+            break
+        if len(data) == 8 and data[0] < 7:
+            frames.setdefault(node, {})[data[0]] = data[1:]
+    
+    nodes = {}
+    for node, f in frames.items():
+        if len(f) == 7:
+            raw = b''.join(bytes(f[i]) for i in range(7))
+            nodes[node] = (bytes(reversed(raw[0:16])), raw[16:].split(b'\0')[0].decode(errors='replace'))
+    return nodes
+
+def read_register(bus, nickname, reg):
+    vscp_send(bus, vscp.read_register, [nickname, reg])
+    deadline = time.time() + 0.5
+    while True:
+        node, data = vscp_recv(bus, vscp.rw_response, deadline, origin=nickname)
+        if node == None:
+            raise no_reply
+        if len(data) == 2 and data[0] == reg:
+            return data[1]
+
+def enter_boot(bus, nickname, guid):
+    # The node checks GUID bytes 0, 3, 5 and 7 and the algorithm, the 
+    # bootloader greets with an acknowledge
+    bus.set_filters(None)
+    drain(bus)
+    try:
+        algorithm = read_register(bus, nickname, reg_boot_loader_algorithm)
+    except no_reply:
+        log('Did not get the bootloader algorithm, correct nickname?')
+        raise
+    
+    vscp_send(bus, vscp.enter_boot_loader, [nickname, algorithm, guid[0], guid[3], guid[5], guid[7], 0, 0])
+    deadline = time.time() + 2.0
+    while True:
+        remaining = deadline - time.time()
+        rx_msg = bus.recv(remaining) if remaining > 0 else None
+        if rx_msg == None:
+            log('Node did not enter the bootloader')
+            raise no_reply
+        if rx_msg.arbitration_id == 0x00001400 | nickname:
+            return
+        if rx_msg.arbitration_id & 0x01ffffff == (vscp.nack_boot_loader.value << 8) | nickname:
+            log('Node refused to enter the bootloader (algorithm 0x{:02X})'.format(algorithm))
+            raise no_reply
+
+def wait_online(bus, guids):
+    # The new firmware announces itself after a reset, maybe with another 
+    # nickname. Returns {nickname: new nickname} of the nodes with these
+    # GUIDs that came online.
+    bus.set_filters(None)
+    deadline = time.time() + online_timeout
+    online = {}
+    announced = set()
+    while len(online) < len(guids):
+        node, data = vscp_recv(bus, vscp.new_node_online, deadline)
+        if node != None and node != 0xff: # not a probe of a nickname
+            announced.add(node)
+        # identify the nodes when all may have announced, a who is there
+        # would miss the announcements meanwhile
+        if node == None or len(announced) >= len(guids) - len(online):
+            for n in announced:
+                rv = who_is_there(bus, n, flush=False)
+                for nickname, guid in guids.items():
+                    if n in rv and rv[n][0] == guid:
+                        online[nickname] = n
+                        log('0x{:02X} online'.format(n) if n == nickname else '0x{:02X} online as 0x{:02X}'.format(nickname, n))
+            announced.clear()
+        if node == None:
+            break
+    for nickname in guids.keys() - online.keys():
+        log('0x{:02X} did not come online with the new firmware'.format(nickname))
+    return online
+
+def discover(bus, args):
+    # {nickname: guid} of the nodes to program
+    if args.all:
+        nodes = who_is_there(bus)
+    else:
+        nodes = {}
+        for nickname in args.nickname:
+            nodes.update(who_is_there(bus, nickname))
+            if nickname not in nodes:
+                log('0x{:02X} did not answer who is there'.format(nickname))
+    if args.mdf:
+        nodes = {n: v for n, v in nodes.items() if v[1] == args.mdf}
+    for n, (guid, mdf) in sorted(nodes.items()):
+        log('Found 0x{:02X} {} {}'.format(n, mdf, ':'.join('{:02X}'.format(b) for b in reversed(guid))))
+    return {n: guid for n, (guid, mdf) in nodes.items()}
+
+def upgrade_node(bus, ih, nickname, args, guid=None, enter=False, delta=False, stage=lambda name: None):
+    # Take the node from its application into the bootloader, program it
+    # and with its GUID confirm it's online with the new firmware
+    if enter:
+        stage('enter')
+        log('Enter bootloader...')
+        enter_boot(bus, nickname, guid)
+    program(bus, ih, nickname, args, delta=delta, stage=stage)
+    if guid != None and args.reset:
+        stage('online')
+        if not wait_online(bus, {nickname: guid}):
+            raise no_reply
+
+def program(bus, ih, nickname, args, delta=False, stage=lambda name: None):
+    filters = [{"can_id":   0x00001400 | nickname, 
                 "can_mask": 0x1FFFFEFF,
                 "extended": True}]
     bus.set_filters(filters)
     
+    window = min(max(args.window, 1), max_window)
+    
     try:
-        send_msg(bus, msg.put_cntrl, data=control_reg(cmd=cmd.rst_chksm))
+        rv = send_msg(bus, msg.put_cntrl, data=control_reg(cmd=cmd.rst_chksm))
     except no_reply:
-        print('Did not get a reply, correct nickname?')
-        exit()
-     
-    print('Program...')
-    checksum = iter_hex(bus, ih, progress=args.progress)
+        log('Did not get a reply, correct nickname?')
+        raise
     
-    if(args.ereedata):
-        checksum += eedata(bus, args.eedatasize, progress=args.progress)
+    if len(rv) < 3 and window > 1:
+        log('Bootloader has no sequence check, waiting for each acknowledge')
+        window = 1
+    
+    pack = False
+    if args.pack and window > 1:
+        rv = send_all(bus, msg.get_cntrl, {nickname}, nickname=nickname, retries=max_resync)
+        pack = bool(rv) and pack_supported(rv.values())
+        if not pack:
+            log('Bootloader takes no packed data, sending it plain')
+     
+    stage('program')
+    log('Program...')
+    try:
+        rows = None
+        if(delta):
+            rows = changed_rows(bus, {nickname}, image_rows(ih, args.eedatasize if args.ereedata else None), progress=args.progress)
+            if rows == None:
+                log('   bootloader has no CRC32, programming all')
+        
+        if rows != None:
+            checksum = put_rows(bus, rows, window, progress=args.progress, pack=pack)
+        else:
+            checksum = iter_hex(bus, ih, progress=args.progress, window=window, pack=pack)
+            
+            if(args.ereedata):
+                checksum += eedata(bus, args.eedatasize, progress=args.progress, window=window, pack=pack)
+    except no_reply:
+        log()
+        log('Lost contact with the bootloader')
+        raise
         
     checksum = (0xFFFF-(checksum & 0xFFFF)+1) & 0xFFFF
     
     if(args.verify):
-        print('Verify...')
-        iter_hex(bus, ih, verify=True, progress=args.progress)
-        if(args.ereedata):
-            eedata(bus, args.eedatasize, progress=args.progress, verify=True)
+        stage('verify')
+        log('Verify...')
+        unsupported = True
+        if not args.readback:
+            segments = list(hex_segments(ih))
+            if(args.ereedata):
+                segments.append(eedata_segment(args.eedatasize))
+            failed, unsupported = verify_crc(bus, {nickname}, segments)
+            if failed:
+                log('Error during verification')
+                raise verify_error
+            if unsupported:
+                log('Bootloader has no CRC32, reading back')
+        if unsupported:
+            iter_hex(bus, ih, verify=True, progress=args.progress)
+            if(args.ereedata):
+                eedata(bus, args.eedatasize, progress=args.progress, verify=True)
     
-    print('Perform checksum check in target...')
-    send_msg(bus, msg.put_cntrl, data=control_reg(cmd=cmd.chk_run, sp_data=checksum, write = True))
+    stage('checksum')
+    log('Perform checksum check in target...')
+    send_msg(bus, msg.put_cntrl, data=control_reg(cmd=cmd.chk_run, sp_data=checksum, write = True), timeout=chk_run_timeout)
     
     if(args.reset):
-        print('Resetting device...')
-        send_msg(bus, msg.put_cntrl, data=control_reg(cmd=cmd.reset))
+        log('Resetting device...')
+        bus.send(can.Message(arbitration_id=msg.put_cntrl.value, data=control_reg(cmd=cmd.reset), is_extended_id=True))
+
+def read_inventory(filename):
+    # One bus per line, the channel followed by the nicknames of its nodes
+    inventory = {}
+    with open(filename) as f:
+        for line in f:
+            words = line.split('#')[0].split()
+            if words:
+                inventory.setdefault(words[0], []).extend(auto_int(w) for w in words[1:])
+    return inventory
+
+def read_done(filename):
+    done = set()
+    try:
+        with open(filename) as f:
+            for line in f:
+                words = line.split()
+                if len(words) == 2:
+                    done.add((words[0], auto_int(words[1])))
+    except FileNotFoundError:
+        pass
+    return done
+
+def upgrade_bus(channel, nicknames, ih, args, status):
+    # Worker for one bus, programs its nodes one by one. A retry only
+    # writes the rows that aren't right yet.
+    output.prefix = '{}: '.format(channel)
+    try:
+        bus = can.interface.Bus(channel=channel, context=args.context)
+    except (can.CanError, OSError) as e:
+        log('Can\'t open the bus: {}'.format(e))
+        for nickname in nicknames:
+            status[(channel, nickname)] = 'failed'
+        return
     
+    for nickname in nicknames:
+        output.prefix = '{} 0x{:02X}: '.format(channel, nickname)
+        guid = None
+        for attempt in range(args.retries + 1):
+            def stage(name):
+                status[(channel, nickname)] = '{} ({})'.format(name, attempt + 1)
+            stage('start')
+            try:
+                # after a failure the node may be left in the bootloader
+                enter = False
+                if args.enter:
+                    rv = who_is_there(bus, nickname)
+                    if nickname in rv:
+                        guid, enter = rv[nickname][0], True
+                    elif guid == None:
+                        log('Did not answer who is there, expecting it in the bootloader')
+                upgrade_node(bus, ih, nickname, args, guid=guid, enter=enter, delta=args.delta or attempt > 0, stage=stage)
+            except (no_reply, verify_error, can.CanError):
+                time.sleep(1.0)
+                continue
+            status[(channel, nickname)] = 'done'
+            with output_lock:
+                with open(args.done, 'a') as f:
+                    f.write('{} 0x{:02X}\n'.format(channel, nickname))
+            break
+        else:
+            status[(channel, nickname)] = 'failed'
     
-            
+    bus.shutdown()
+
+def upgrade_inventory(ih, args):
+    # One worker per bus, so the upgrade takes as long as the slowest bus
+    done = read_done(args.done)
+    inventory = read_inventory(args.inventory)
+    status = {}
+    workers = []
+    for channel, nicknames in inventory.items():
+        for nickname in nicknames:
+            status[(channel, nickname)] = 'done' if (channel, nickname) in done else 'waiting'
+        nicknames = [n for n in nicknames if (channel, n) not in done]
+        if nicknames:
+            workers.append(threading.Thread(target=upgrade_bus, args=(channel, nicknames, ih, args, status)))
+    
+    args.progress = False
+    for w in workers:
+        w.start()
     
+    while any(w.is_alive() for w in workers):
+        time.sleep(5.0)
+        states = list(status.items())
+        busy = ['{} 0x{:02X} {}'.format(c, n, s) for (c, n), s in states if s not in ('done', 'failed', 'waiting')]
+        log('{}/{} done, {} failed | {}'.format(sum(s == 'done' for k, s in states), len(states), 
+                                                sum(s == 'failed' for k, s in states), ', '.join(busy)))
     
+    failed = sorted(k for k, s in status.items() if s == 'failed')
+    for channel, nickname in failed:
+        log('Failed: {} 0x{:02X}'.format(channel, nickname))
+    log('{} of {} nodes programmed, run again to retry the failed ones'.format(len(status) - len(failed), len(status)) 
+        if failed else 'All {} nodes programmed'.format(len(status)))
 
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Program a PIC controller on CAN bus using the VSCP CAN Bootloader. Please look at Python-Can documentation for CAN configuration.")
+    parser.add_argument('filename', help='Intel HEX file to be programmed')
+    parser.add_argument('-c', '--context', dest='context', default='default', help='CAN bus context to use from CAN config file')
+    parser.add_argument('-n', '--nick', dest='nickname', help='VSCP Nickname of node, several nodes in boot mode are programmed at once (default=0xFE)', default=[0xFE], type=auto_int, nargs='+')
+    parser.add_argument('-P', '--noprogress', dest='progress', action='store_false', help='No progress indicators')
+    parser.add_argument('-V', '--noverify', dest='verify', action='store_false', help='No verification after writing')
+    parser.add_argument('-R', '--noreset', dest='reset', action='store_false', help='No reset when done')
+    parser.add_argument('-e', '--eedataerase', dest='ereedata', action='store_true', help='Erase EEDATA')
+    parser.add_argument('-s', '--eedatasize', dest='eedatasize', help='EEDATA size for erasing (default=0xFF)', default=0xFF, type=auto_int)
+    parser.add_argument('-d', '--delta', dest='delta', action='store_true', help='Only write the erase rows that changed')
+    parser.add_argument('-r', '--readback', dest='readback', action='store_true', help='Verify by reading back instead of by CRC32')
+    parser.add_argument('-w', '--window', dest='window', help='Number of data frames in flight, 1 waits for each acknowledge (default=2)', default=2, type=int)
+    parser.add_argument('-i', '--inventory', dest='inventory', help='Program the nodes of an inventory file, one line per bus: channel nickname ..., the buses in parallel')
+    parser.add_argument('--nopack', dest='pack', action='store_false', help='Send plain data even if the bootloader takes packed data')
+    parser.add_argument('--retries', dest='retries', help='Retries per node of an inventory (default=2)', default=2, type=int)
+    parser.add_argument('-E', '--enter', dest='enter', action='store_true', help='Find the nodes with who is there and take them from the application into the bootloader, confirm they come online after programming')
+    parser.add_argument('-a', '--all', dest='all', action='store_true', help='With --enter, program all nodes that answer who is there')
+    parser.add_argument('-m', '--mdf', dest='mdf', help='With --enter, only program the nodes with this MDF name')
+    parser.add_argument('--done', dest='done', help='Nodes of an inventory already programmed, these are skipped (default=canload.done)', default='canload.done')
+        
+    args = parser.parse_args()
+    
+    ih = intelhex.IntelHex(args.filename)  # this performs checks on the input file
+    
+    if args.inventory:
+        upgrade_inventory(ih, args)
+        exit()
+    
+    bus = can.interface.Bus(context=args.context)
+    
+    guids = {}
+    if args.enter:
+        guids = discover(bus, args)
+        if not guids:
+            log('No nodes to program')
+            exit()
+        args.nickname = sorted(guids)
+    
+    if len(args.nickname) > 1:
+        nodes = set(args.nickname)
+        for nickname, guid in sorted(guids.items()):
+            output.prefix = '0x{:02X}: '.format(nickname)
+            try:
+                enter_boot(bus, nickname, guid)
+            except no_reply:
+                nodes.discard(nickname)
+        output.prefix = ''
+        bus.set_filters([{"can_id": 0x00001400, "can_mask": 0x1FFFFE00, "extended": True}])
+        failed = multicast(bus, ih, nodes, args)
+        if guids and args.reset:
+            wait_online(bus, {n: guids[n] for n in nodes - failed})
+        exit()
+    
+    try:
+        nickname = args.nickname[0]
+        upgrade_node(bus, ih, nickname, args, guid=guids.get(nickname), enter=args.enter, delta=args.delta)
+    except (no_reply, verify_error):
+        exit()
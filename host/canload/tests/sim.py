@@ -0,0 +1,189 @@
+# A simulated CAN bus with nodes in the VSCP bootloader, standing in for
+# python-can in the tests. The nodes reply at once, so recv() never waits.
+import random
+import zlib
+
+class Message:
+    def __init__(self, arbitration_id=0, data=bytearray(), is_extended_id=True):
+        self.arbitration_id = arbitration_id
+        self.data = bytearray(data)
+        self.is_extended_id = is_extended_id
+
+class Unpacker:
+    """The decoder of packed puts (CMD_PACK), writing whole blocks of 8
+    bytes as the bootloader does. A copy may only read blocks written."""
+    def __init__(self, node, address):
+        self.node = node
+        self.address = address
+        self.block = bytearray()
+        self.count = 0
+        self.operands = []
+        self.control = 0
+
+    def out(self, value):
+        self.block.append(value)
+        if len(self.block) == 8:
+            for i, value in enumerate(self.block):
+                self.node.memory[self.address + i] = value
+                self.node.checksum += value
+            self.address += 8
+            self.block = bytearray()
+
+    def put(self, c):
+        if self.count and self.control >= 0x80:
+            self.operands.append(c)
+            if self.control < 0xC0:
+                for i in range(self.count):
+                    self.out(c)
+                self.count = 0
+            elif len(self.operands) == 2:
+                source = self.address + len(self.block) - (self.operands[0] | (self.operands[1] << 8))
+                for i in range(self.count):
+                    if source >= self.address:
+                        raise AssertionError('copy from 0x{:06X} before it is written'.format(source))
+                    self.out(self.node.memory.get(source, 0xFF))
+                    source += 1
+                self.count = 0
+        elif self.count:
+            self.out(c)
+            self.count -= 1
+        else:
+            self.control = c
+            self.operands = []
+            self.count = c + 1 if c < 0x80 else (c & 0x3F) + 3
+
+class Node:
+    """The bootloader of one node, memory starts blank (0xFF)"""
+    ack_flag = 0x10
+    seq_flag = 0x20
+    mute_flag = 0x40
+    pack_flag = 0x80
+    seq_error = 0x02
+    align_error = 0x04
+    pack_support = 0x80
+
+    def __init__(self, nickname, pack=False):
+        self.nickname = nickname
+        self.memory = {}
+        self.control = bytearray(8)
+        self.status = self.pack_support if pack else 0
+        self.checksum = 0
+        self.unpacker = None
+
+    def pointer(self):
+        return self.control[0] | (self.control[1] << 8) | (self.control[2] << 16)
+
+    def set_pointer(self, address):
+        self.control[0:3] = address.to_bytes(3, 'little')
+
+    def reply(self, msg_type, data):
+        return Message(0x1400 | (msg_type & 0x0100) | self.nickname, data)
+
+    def receive(self, msg):
+        # Returns the reply or None
+        msg_type = msg.arbitration_id & 0xFF00
+        eidl = msg.arbitration_id & 0xFF
+        flags = self.control[4]
+        if msg_type == 0x1000:
+            if eidl not in (0, self.nickname):
+                return None
+            self.control[:len(msg.data)] = msg.data
+            self.status &= ~self.seq_error
+            cmd = self.control[5]
+            pointer = self.control[0:3]
+            if cmd == 0x00:
+                return self.reply(msg_type, pointer)
+            if cmd == 0x01:
+                return None
+            if cmd == 0x02:
+                self.checksum = 0
+                self.status &= ~self.align_error
+            if cmd == 0x05 and self.status & self.pack_support:
+                self.unpacker = Unpacker(self, self.pointer())
+                return self.reply(msg_type, pointer)
+            if cmd == 0x04:
+                size = self.control[6] | (self.control[7] << 8)
+                data = bytes(self.memory.get(self.pointer() + i, 0xFF) for i in range(size))
+                return self.reply(msg_type, zlib.crc32(data).to_bytes(4, 'little'))
+            return self.reply(msg_type, pointer) if self.control[4] & self.ack_flag else None
+        if msg_type == 0x1200:
+            data = bytearray(self.control)
+            data[3] = self.status
+            data[6:8] = (self.checksum & 0xFFFF).to_bytes(2, 'little')
+            return self.reply(msg_type, data)
+        if msg_type == 0x1300:
+            address = self.pointer()
+            self.set_pointer(address + 8)
+            return self.reply(msg_type, bytearray(self.memory.get(address + i, 0xFF) for i in range(8)))
+        # put data
+        if flags & self.mute_flag:
+            return None
+        if flags & self.seq_flag:
+            if self.status & self.seq_error:
+                return None
+            if eidl != self.control[0]:
+                if flags & self.ack_flag:
+                    return self.reply(msg_type, self.control[0:3])
+                self.status |= self.seq_error
+                return None
+        address = self.pointer()
+        if flags & self.pack_flag and self.status & self.pack_support:
+            for c in msg.data:
+                self.unpacker.put(c)
+            self.set_pointer(address + len(msg.data))
+            return self.reply(msg_type, self.control[0:3]) if flags & self.ack_flag else None
+        if address < 0x300000 and (address % 8 or len(msg.data) != 8):
+            self.status |= self.align_error
+            return self.reply(msg_type, self.control[0:3]) if flags & self.ack_flag else None
+        for i, value in enumerate(msg.data):
+            self.memory[address + i] = value
+            self.checksum += value
+        self.set_pointer(address + len(msg.data))
+        return self.reply(msg_type, self.control[0:3]) if flags & self.ack_flag else None
+
+class Bus:
+    """Frames are lost with probability loss, on the way to each node and
+    on the way back, or when lose(node, msg) says so"""
+    def __init__(self, nodes, loss=0.0, lose=lambda node, msg: False, seed=1):
+        self.nodes = nodes
+        self.loss = loss
+        self.lose = lose
+        self.random = random.Random(seed)
+        self.received = []
+
+    def set_filters(self, filters):
+        pass
+
+    def send(self, msg):
+        for node in self.nodes:
+            if self.random.random() < self.loss or self.lose(node, msg):
+                continue
+            reply = node.receive(msg)
+            if reply is not None and self.random.random() >= self.loss:
+                self.received.append(reply)
+
+    def recv(self, timeout=None):
+        return self.received.pop(0) if self.received else None
+
+class Image:
+    """The part of intelhex.IntelHex that canload uses"""
+    def __init__(self, data):
+        self.data = data
+
+    def segments(self):
+        segments = []
+        for address in sorted(self.data):
+            if segments and segments[-1][1] == address:
+                segments[-1][1] += 1
+            else:
+                segments.append([address, address + 1])
+        return [tuple(s) for s in segments]
+
+    def __getitem__(self, address):
+        return self.data.get(address, 0xFF)
+
+class interface:
+    Bus = Bus
+
+# python-can and intelhex are not needed to run the tests
+IntelHex = Image
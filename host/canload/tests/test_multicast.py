@@ -0,0 +1,99 @@
+import contextlib
+import io
+import sys
+import types
+import unittest
+from . import sim
+
+try:
+    import can
+except ImportError:
+    sys.modules['can'] = sim
+try:
+    import intelhex
+except ImportError:
+    sys.modules['intelhex'] = sim
+
+import canload
+
+image = {0x800 + i: (i * 7) & 0xFF for i in range(3000)}
+image.update({0x2000 + i: i & 0xFF for i in range(100)})
+
+def args(**kwargs):
+    a = dict(progress=False, verify=True, reset=False, ereedata=False, eedatasize=0xFF,
+             delta=False, readback=False, pack=True)
+    a.update(kwargs)
+    return types.SimpleNamespace(**a)
+
+def lose_put(nickname, address, times=1):
+    # Lose the put of address to one node
+    lost = []
+    def lose(node, msg):
+        if (node.nickname == nickname and msg.arbitration_id & 0xFF00 == 0x1100 and
+                node.pointer() == address and len(lost) < times):
+            lost.append(msg)
+            return True
+        return False
+    return lose
+
+class MulticastTest(unittest.TestCase):
+    def setUp(self):
+        canload.prog_gap = 0
+        canload.eedata_gap = 0
+
+    def program(self, nicknames, present=None, pack=False, **kwargs):
+        nodes = [sim.Node(n, pack) for n in (present or nicknames)]
+        output = io.StringIO()
+        with contextlib.redirect_stdout(output):
+            canload.multicast(sim.Bus(nodes, **kwargs), sim.Image(image), set(nicknames), args())
+        return nodes, output.getvalue()
+
+    def assertProgrammed(self, node):
+        self.assertTrue(all(node.memory.get(a) == v for a, v in image.items()),
+                        'node 0x{:02X} not programmed'.format(node.nickname))
+
+    def test_programmed(self):
+        nodes, output = self.program({1, 2, 3})
+        for node in nodes:
+            self.assertProgrammed(node)
+        self.assertIn('All 3 nodes programmed', output)
+        self.assertNotIn('resend', output)
+
+    def test_lost_put_resent(self):
+        nodes, output = self.program({1, 2, 3}, lose=lose_put(2, 0x1000))
+        for node in nodes:
+            self.assertProgrammed(node)
+        self.assertIn('resend 0x001000', output)
+
+    def test_lagging_nodes_rearmed(self):
+        # each node is armed again when the resent stream reaches its pointer
+        def lose(node, msg):
+            return first(node, msg) or second(node, msg)
+        first = lose_put(1, 0x0900)
+        second = lose_put(3, 0x1200)
+        nodes, output = self.program({1, 2, 3}, lose=lose)
+        for node in nodes:
+            self.assertProgrammed(node)
+        self.assertIn('All 3 nodes programmed', output)
+
+    def test_lossy_bus(self):
+        for seed in range(3):
+            nodes, output = self.program({1, 2, 3}, loss=0.02, seed=seed)
+            for node in nodes:
+                self.assertProgrammed(node)
+
+    def test_packed(self):
+        for seed in range(3):
+            nodes, output = self.program({1, 2, 3}, pack=True, loss=0.02, seed=seed)
+            for node in nodes:
+                self.assertProgrammed(node)
+            self.assertNotIn('sending it plain', output)
+
+    def test_missing_node(self):
+        nodes, output = self.program({1, 2, 9}, present={1, 2})
+        for node in nodes:
+            self.assertProgrammed(node)
+        self.assertIn('Failed: 0x09', output)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,66 @@
+import random
+import sys
+import unittest
+from . import sim
+
+try:
+    import can
+except ImportError:
+    sys.modules['can'] = sim
+try:
+    import intelhex
+except ImportError:
+    sys.modules['intelhex'] = sim
+
+import canload
+
+def code(size, seed=1):
+    # Something like compiled code: a few instruction patterns with
+    # different operands, repeated tables and blank padding
+    rnd = random.Random(seed)
+    patterns = [bytes(rnd.randrange(256) for i in range(rnd.randrange(4, 24))) for j in range(20)]
+    data = bytearray()
+    while len(data) < size:
+        pattern = bytearray(rnd.choice(patterns))
+        pattern[rnd.randrange(len(pattern))] = rnd.randrange(256)
+        data += pattern
+        if rnd.random() < 0.05:
+            data += b'\xFF' * rnd.randrange(8, 300)
+    return data[:size]
+
+def unpack(start, stream):
+    node = sim.Node(0, pack=True)
+    unpacker = sim.Unpacker(node, start)
+    for c in stream:
+        unpacker.put(c)
+    return bytearray(node.memory.get(start + i, 0xFF) for i in range(len(node.memory)))
+
+class PackTest(unittest.TestCase):
+    samples = [code(4096), bytearray(random.Random(2).randrange(256) for i in range(1000)),
+               bytearray(b'\xFF' * 2048), bytearray(b'\x12\x34' * 500), code(64, seed=3)]
+
+    def test_round_trip(self):
+        for data in self.samples:
+            self.assertEqual(unpack(0x800, canload.packed(0x800, data)), data)
+
+    def test_eedata_without_copies(self):
+        data = bytearray(b'\x55\xAA' * 64) + bytearray(b'\xFF' * 128)
+        stream = canload.packed(0xF00000, data)
+        self.assertEqual(unpack(0xF00000, stream), data)
+        self.assertEqual(stream, canload.pack_stream(data, canload.eedata_run, copies=False))
+
+    def test_copies_shrink_code(self):
+        data = self.samples[0]
+        with_copies = canload.pack_stream(data)
+        runs_only = canload.pack_stream(data, copies=False)
+        self.assertLess(len(with_copies), 0.75 * len(runs_only))
+
+    def test_written(self):
+        for data in self.samples:
+            stream = canload.packed(0x800, data)
+            written = canload.pack_written(stream)
+            self.assertEqual(len(written), (len(stream) + 7) // 8)
+            self.assertEqual(sum(written), len(data))
+
+if __name__ == '__main__':
+    unittest.main()
@@ -34,8 +34,60 @@ class Channel:
     async def set_name(self, reg, name):
         name = name.encode('UTF-8')
         name = bytearray(name) + b'\00' * (16 - len(name))
-        for i in range(0, 16, 4):
-            await self.node.write_reg(self.index, reg + i, name[i:i + 4])
+        await asyncio.gather(*(self.node.write_reg(self.index, reg + i, name[i:i + 4])
+                               for i in range(0, 16, 4)))
+
+class NodeSettings(Channel):
+    """Node wide registers, located on their own page."""
+    PAGE = 0x100
+
+    def __init__(self, node):
+        self.node = node
+        self.index = self.PAGE
+        self.reglist = {0x03: ('Coalesce states', True),
+                        0x04: ('Holdoff x10ms', True),
+                        0x05: ('Zone', True),
+                        0x06: ('Subzone', True),
+                        0x07: ('Ramp x100ms', True),
+                        0x08: ('Repeat x10ms', True)}
+        for i in range(node.NUM_SCENES):
+            reg = 0x20 + 4 * i
+            self.reglist[reg] = ('Scene {} id'.format(i), True)
+            self.reglist[reg + 1] = ('Scene {} mask'.format(i), True)
+            self.reglist[reg + 2] = ('Scene {} states H'.format(i), True)
+            self.reglist[reg + 3] = ('Scene {} states L'.format(i), True)
+        for i in range(node.NUM_DM_ROWS):
+            reg = 0x40 + 8 * i
+            for j, field in enumerate(('oaddr', 'flags', 'class mask',
+                                       'class filter', 'type mask',
+                                       'type filter', 'action', 'param')):
+                self.reglist[reg + j] = ('DM {} {}'.format(i, field), True)
+        self.num_registers = max(self.reglist) + 1
+
+    async def set_scene(self, index, scene_id, states):
+        """Store a scene, states maps output index to 0=off, 1=on,
+        2=fast flash, 3=slow flash. Outputs not in states are left alone."""
+        if not 0 <= index < self.node.NUM_SCENES:
+            raise IndexError('no scene {} on this node'.format(index))
+        mask = 0
+        packed = 0
+        for output, state in states.items():
+            mask |= 1 << output
+            packed |= (state & 0x03) << (2 * output)
+        await self.node.write_reg(self.index, 0x20 + 4 * index,
+                                  struct.pack('>BBH', scene_id, mask, packed))
+
+    async def set_dm_row(self, index, row):
+        """Store a decision matrix row, given as its 8 register bytes."""
+        if not 0 <= index < self.node.NUM_DM_ROWS:
+            raise IndexError('no decision matrix row {} on this node'.format(index))
+        reg = 0x40 + 8 * index
+        await self.node.write_reg(self.index, reg, bytes(row[0:4]))
+        await self.node.write_reg(self.index, reg + 4, bytes(row[4:8]))
+
+    async def name(self):
+        return 'Node settings'
+
 
 class Light(Channel):
     def __init__(self, node, index):
@@ -50,8 +102,14 @@ class Light(Channel):
                         0x21: ('On time mins', True),
                         0x22: ('Act on time hrs', False),
                         0x23: ('Act on time mins', False),
-                        0x24: ('Invert', True)}
-        self.num_registers = 40
+                        0x24: ('Invert', True),
+                        0x25: ('On time secs H', True),
+                        0x26: ('On time secs L', True),
+                        0x27: ('Remaining secs H', False),
+                        0x28: ('Remaining secs L', False),
+                        0x29: ('Level', True),
+                        0x2A: ('Dimmed', True)}
+        self.num_registers = 43
 
     @staticmethod
     def _get_name(registers):
@@ -68,6 +126,11 @@ class Light(Channel):
         reg_data = await self.node.read_reg(self.index, 0x06, 0x02)
         return int(reg_data[0]), int(reg_data[1])
 
+    async def set_on_time(self, seconds):
+        """Auto-off timer in seconds (max 65535), 0 disables it."""
+        await self.node.write_reg(self.index, 0x25,
+                                  struct.pack('>H', min(seconds, 0xFFFF)))
+
 
 
 class Switch(Channel):
@@ -82,7 +145,10 @@ class Switch(Channel):
                         0x21: ('Subzone', True),
                         0x22: ('Type', True),
                         0x23: ('Invert', True),
-                        0x24: ('ON flash type', True)}
+                        0x24: ('ON flash type', True),
+                        0x25: ('Long press x10ms', True),
+                        0x26: ('Double click x10ms', True),
+                        0x27: ('Hold to dim', True)}
         self.num_registers = 40
 
     @staticmethod
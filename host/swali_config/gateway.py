@@ -1,6 +1,7 @@
-from vscp.util import who_is_there
+import asyncio
+from vscp.util import who_is_there_all
 from vscp.tcp import TCP
-from vscp.filter import Filter
+from vscp.mux import RegisterMux, RegTimeout
 from node import Node
 
 
@@ -10,29 +11,32 @@ class Gateway(TCP):
         """Initialize a Gateway object"""
         super().__init__(*args, **kwargs)
         self.nodes = dict() # list of nodes
+        self.mux = RegisterMux(self) # register access of the nodes
 
     async def start_update(self):
-        await self.quitloop()
-        flt = Filter(0,0,0,0,0,0)
-        await self.setmask(flt)
-        await self.setfilter(flt)
-        await self.clrall()
-        await self.rcvloop(self._process_event)
+        await self.subscribe(self._process_event)
 
     async def scan(self):
         """Scan a gateway for devices, build the channel lists"""
-        await self.quitloop()
+        found = await who_is_there_all(self)
 
-        for nickname in range(128):
-            (guid, mdf) = await who_is_there(self, nickname)
+        # the registers of all nodes are read in parallel
+        nodes = await asyncio.gather(*(self._new_node(nickname, guid, mdf)
+                                       for nickname, (guid, mdf) in found.items()),
+                                     return_exceptions=True)
+        for nickname, node in zip(found, nodes):
+            if isinstance(node, RegTimeout):
+                print('Node {} does not answer register reads'.format(nickname))
+            elif isinstance(node, Exception):
+                raise node
+            else:
+                self.nodes[nickname] = node
 
-            if (guid, mdf) != (None, None):
-                try:
-                    device_obj = __import__(mdf)
-                    self.nodes[nickname] = await getattr(device_obj, mdf.title()).new(self, nickname, guid, mdf)
-                except (ImportError, ValueError):
-                    self.nodes[nickname] = Node(self, nickname)
-                    await self.nodes[nickname].init()
-
-                #node = await Node.new(self, nickname, guid, mdf)
-                #self.nodes[nickname] = node
+    async def _new_node(self, nickname, guid, mdf):
+        try:
+            device_obj = __import__(mdf)
+            return await getattr(device_obj, mdf.title()).new(self, nickname, guid, mdf)
+        except (ImportError, ValueError):
+            node = Node(self, nickname)
+            await node.init()
+            return node
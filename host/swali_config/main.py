@@ -13,32 +13,33 @@ def show_nodes(gw):
         print('{:3} - {:32} - {}'.format(nick, node.mdf, node.version))
 
 async def wait_onoff_event(vscp):
-    await vscp.quitloop()
-    flt = Filter(0,0,CLASS_INFORMATION,0x3ff,EVENT_INFORMATION_ON,0xFF)
-    await vscp.setmask(flt)
-    await vscp.setfilter(flt)
-    await vscp.clrall()
+    async with vscp.polling():
+        flt = Filter(0,0,CLASS_INFORMATION,0x3ff,EVENT_INFORMATION_ON,0xFF)
+        await vscp.setmask(flt)
+        await vscp.setfilter(flt)
+        await vscp.clrall()
 
-    for i in range(30,0,-1):
-        await asyncio.sleep(0.5)
-        print(i)
-        resp = (await vscp.retr(1))
-        if bytes('+OK'.encode()) in resp[0]:
-            break
-        else:
-            resp = None
+        for i in range(30,0,-1):
+            await asyncio.sleep(0.5)
+            print(i)
+            resp = (await vscp.retr(1))
+            if bytes('+OK'.encode()) in resp[0]:
+                break
+            else:
+                resp = None
     if resp is None:
         raise NoInput
     ev = resp[1][0]
     return ev.guid.nickname, ev.data[0]
 
 async def binding_mode(gw):
-    lights = list()
-    for node in gw.nodes.values():
-        lights.extend([ch for ch in node.channels if (type(ch).__name__ == 'Light') and await ch.enabled()])
+    channels = [ch for node in gw.nodes.values() for ch in node.channels
+                if type(ch).__name__ == 'Light']
+    enabled = await asyncio.gather(*(ch.enabled() for ch in channels))
+    lights = [ch for ch, on in zip(channels, enabled) if on]
 
     while(True):
-        names = [await light.name() for light in lights]
+        names = await asyncio.gather(*(light.name() for light in lights))
         for idx, light in enumerate(lights):
             print('{} - {}'.format(idx, names[idx]))
         id = input('Select light to bind to, q to quit. > ')
@@ -1,6 +1,7 @@
-from vscp.util import write_reg, read_reg
+import asyncio
 from vscp.const import STD_REG_FW_MAJOR, STD_REG_MDF, STD_REG_GUID
 from vscp.guid import Guid
+from channel import NodeSettings
 
 class Version:
     def __init__(self, raw):
@@ -13,6 +14,10 @@ class Version:
 
 
 class Node:
+    # scene table and decision matrix sizes, as in the firmware's swali_config.h
+    NUM_SCENES = 0
+    NUM_DM_ROWS = 0
+
     def __init__(self, gw, nick, guid=None, mdf=None):
         self.gw = gw
         self.nick = nick
@@ -20,32 +25,42 @@ class Node:
         self.version = None
         self.mdf = mdf
         self.guid = guid
+        self.settings = NodeSettings(self)
 
     async def init(self):
-        self.version = Version(await read_reg(self.gw, self.nick, 0, STD_REG_FW_MAJOR, 3))
+        # the GUID and MDF registers are contiguous, they come in one read
+        reads = [self.read_reg(0, STD_REG_FW_MAJOR, 3)]
+        if self.mdf is None:
+            reads.append(self.read_reg(0, STD_REG_MDF, 32))
+        if self.guid is None:
+            reads.append(self.read_reg(0, STD_REG_GUID, 16))
+        raw = await asyncio.gather(*reads)
+        self.version = Version(raw.pop(0))
         if self.mdf is None:
-            self.mdf = (await read_reg(self.gw, self.nick, 0, STD_REG_MDF, 32)).decode().rstrip('/x0')
+            self.mdf = raw.pop(0).decode().rstrip('/x0')
         if self.guid is None:
-            self.guid = Guid(await read_reg(self.gw, self.nick, 0, STD_REG_GUID, 16))
+            self.guid = Guid(raw.pop(0))
 
     async def read_reg(self, channel, reg, num=1):
-        return await read_reg(self.gw, self.nick, channel, reg, num)
+        return await self.gw.mux.read(self.nick, channel, reg, num)
 
     async def write_reg(self, channel, reg, value):
-        await write_reg(self.gw, channel, reg, self.nick, value)
+        return await self.gw.mux.write(self.nick, channel, reg, value)
 
     async def menu(self):
         print('GUID: {}'.format(self.guid))
         while True:
-            print('Select channel, b to enter bootloader, q to quit.  > ')
-            for i, channel in enumerate(self.channels):
-                name = await channel.name()
+            print('Select channel, n for node settings, b to enter bootloader, q to quit.  > ')
+            names = await asyncio.gather(*(channel.name() for channel in self.channels))
+            for i, (channel, name) in enumerate(zip(self.channels, names)):
                 print(' {:3} - {} {}'.format(i, type(channel).__name__, name))
             ui = input('> ')
             if ui == 'q':
                 break
             elif ui == 'b':
                 pass
+            elif ui == 'n':
+                await self.settings.menu()
             else:
                 try:
                     await self.channels[int(ui)].menu()
@@ -3,6 +3,9 @@ from channel import Light, Switch
 
 
 class Paris_Z01(Node):
+    NUM_SCENES = 8
+    NUM_DM_ROWS = 4
+
     def __init__(self, gw, nick, guid, mdf):
         super().__init__(gw, nick, guid, mdf)
         for i in range(7):
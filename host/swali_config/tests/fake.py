@@ -0,0 +1,58 @@
+from vscp.guid import Guid
+from vscp.tcp import TCP
+
+class FakeDaemon(TCP):
+    """Stands in for the connection to the VSCP daemon. Events sent by the
+    nodes pass the mask and filter set by the client, like in vscpd, and
+    go to the receive loop or are buffered for retr."""
+    def __init__(self):
+        super().__init__()
+        self.mask = None
+        self.filter = None
+        self.buffer = list()
+        self.sent = list()
+        self.replies = None  # function of a sent event giving the node events
+        self._callback = None
+
+    async def quitloop(self):
+        self._rcvloop = False
+        self._callback = None
+
+    async def rcvloop(self, callback):
+        self._rcvloop = True
+        self._callback = callback
+
+    async def setmask(self, flt):
+        self.mask = flt
+
+    async def setfilter(self, flt):
+        self.filter = flt
+
+    async def clrall(self):
+        self.buffer.clear()
+
+    async def send(self, ev):
+        self.sent.append(ev)
+        if self.replies:
+            for reply in self.replies(ev):
+                await self.receive(reply)
+
+    async def retr(self, num=1):
+        events = self.buffer[:num]
+        del self.buffer[:num]
+        return ('+OK' if events else '-OK', events)
+
+    async def receive(self, ev):
+        if self.mask is not None and not self.passes(ev):
+            return
+        if self._callback:
+            await self._callback(ev)
+        else:
+            self.buffer.append(ev)
+
+    def passes(self, ev):
+        return ((ev.vscp_class ^ self.filter.event_class) & self.mask.mask_class == 0 and
+                (ev.vscp_type ^ self.filter.type) & self.mask.mask_type == 0)
+
+def node_guid(nickname):
+    return Guid(bytes(15) + bytes([nickname]))
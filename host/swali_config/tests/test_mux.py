@@ -0,0 +1,75 @@
+import asyncio
+import struct
+import unittest
+from vscp.const import (CLASS_VSCP,
+                        CLASS_INFORMATION,
+                        EVENT_EXT_PAGE_READ,
+                        EVENT_EXT_PAGE_RESP,
+                        EVENT_INFORMATION_ON)
+from vscp.event import Event
+from vscp.mux import RegisterMux, RegTimeout
+from vscp.util import who_is_there
+from .fake import FakeDaemon, node_guid
+
+def page_replies(ev):
+    """Nodes 1..9 where each register holds its own number"""
+    if ev.vscp_type != EVENT_EXT_PAGE_READ:
+        return []
+    nickname, page, reg, num = struct.unpack('>BHBB', ev.data)
+    if not 1 <= nickname <= 9:
+        return []
+    replies = []
+    for offset in range(0, num or 256, 4):
+        data = bytes((reg + offset + i) & 0xFF for i in range(min(4, num - offset)))
+        replies.append(Event(vscp_class=CLASS_VSCP, vscp_type=EVENT_EXT_PAGE_RESP,
+                             data=struct.pack('>BHB', 0, page, reg + offset) + data,
+                             guid=node_guid(nickname)))
+    return replies
+
+class RegisterMuxTest(unittest.TestCase):
+    def run_mux(self, test):
+        async def run():
+            daemon = FakeDaemon()
+            daemon.replies = page_replies
+            return await test(daemon, RegisterMux(daemon, timeout=0.05))
+        return asyncio.run(run())
+
+    def test_parallel_reads(self):
+        async def test(daemon, mux):
+            return await asyncio.gather(*(mux.read(n, 0, 0x10, 3) for n in range(1, 10)))
+        self.assertEqual(self.run_mux(test), [bytearray([0x10, 0x11, 0x12])] * 9)
+
+    def test_other_subscriber(self):
+        # another receive loop user, like Gateway.start_update(), still gets
+        # its events and the mux its replies
+        async def test(daemon, mux):
+            seen = list()
+            async def callback(ev):
+                seen.append(ev)
+            await daemon.subscribe(callback)
+            value = await mux.read(3, 0, 0x20, 2)
+            await daemon.receive(Event(vscp_class=CLASS_INFORMATION,
+                                       vscp_type=EVENT_INFORMATION_ON,
+                                       data=bytes(3), guid=node_guid(3)))
+            return value, [ev.vscp_type for ev in seen]
+        value, seen = self.run_mux(test)
+        self.assertEqual(value, bytearray([0x20, 0x21]))
+        self.assertIn(EVENT_EXT_PAGE_RESP, seen)
+        self.assertIn(EVENT_INFORMATION_ON, seen)
+
+    def test_after_polling(self):
+        # the receive loop comes back after a polling function from util
+        async def test(daemon, mux):
+            await mux.read(1, 0, 0, 1)
+            await who_is_there(daemon, 1)
+            return await mux.read(2, 0, 5, 1)
+        self.assertEqual(self.run_mux(test), bytearray([5]))
+
+    def test_timeout(self):
+        async def test(daemon, mux):
+            with self.assertRaises(RegTimeout):
+                await mux.read(20, 0, 0, 1)
+        self.run_mux(test)
+
+if __name__ == '__main__':
+    unittest.main()
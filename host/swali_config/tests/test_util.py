@@ -0,0 +1,72 @@
+import asyncio
+import unittest
+from unittest import mock
+from vscp.const import (CLASS_INFORMATION,
+                        CLASS_CONTROL,
+                        EVENT_CONTROL_SYNC,
+                        EVENT_INFORMATION_STATE,
+                        EVENT_WHO_IS_THERE,
+                        EVENT_WHO_IS_THERE_RESPONSE,
+                        WHO_IS_THERE_FRAMES)
+from vscp.event import Event
+from vscp.util import read_states, who_is_there_all
+from .fake import FakeDaemon, node_guid
+
+def state_replies(ev):
+    """A node 5 with 16 channels, 0 and 9 on, 10 flashing"""
+    if ev.vscp_class != CLASS_CONTROL or ev.vscp_type != EVENT_CONTROL_SYNC:
+        return []
+    return [Event(vscp_class=CLASS_INFORMATION, vscp_type=EVENT_INFORMATION_STATE,
+                  data=bytes([0, 255, 255, 0xFF, 0x01, 0x00]), guid=node_guid(5)),
+            Event(vscp_class=CLASS_INFORMATION, vscp_type=EVENT_INFORMATION_STATE,
+                  data=bytes([8, 255, 255, 0xFF, 0x02, 0x04]), guid=node_guid(5))]
+
+class ReadStatesTest(unittest.TestCase):
+    def test_state_reply_parsed(self):
+        daemon = FakeDaemon()
+        daemon.replies = state_replies
+        states = asyncio.run(read_states(daemon, 5))
+        expected = {channel: 0 for channel in range(16)}
+        expected.update({0: 1, 9: 1, 10: 2})
+        self.assertEqual(states, {5: expected})
+
+    def test_other_class_ignored(self):
+        daemon = FakeDaemon()
+        daemon.replies = lambda ev: [Event(vscp_class=0, vscp_type=EVENT_INFORMATION_STATE,
+                                           data=bytes(6), guid=node_guid(5))]
+        self.assertEqual(asyncio.run(read_states(daemon, 5)), {})
+
+SLOT = 0.004  # the node at 0xF0 is well past a window for 0..127
+
+def who_is_there_replies(daemon, nicknames):
+    """The nodes answer a broadcast WHO_IS_THERE in the slot of their
+    nickname, as the firmware does"""
+    def replies(ev):
+        if ev.vscp_class != 0 or ev.vscp_type != EVENT_WHO_IS_THERE:
+            return []
+        loop = asyncio.get_running_loop()
+        for nickname in nicknames:
+            if ev.data[0] not in (0xFF, nickname):
+                continue
+            raw = bytes(reversed(bytes(15) + bytes([nickname]))) + b'paris\0'
+            raw += bytes(7 * WHO_IS_THERE_FRAMES - len(raw))
+            for index in range(WHO_IS_THERE_FRAMES):
+                frame = Event(vscp_class=0, vscp_type=EVENT_WHO_IS_THERE_RESPONSE,
+                              data=bytes([index]) + raw[index * 7:index * 7 + 7],
+                              guid=node_guid(nickname))
+                loop.call_later(nickname * SLOT, asyncio.ensure_future, daemon.receive(frame))
+        return []
+    return replies
+
+class WhoIsThereAllTest(unittest.TestCase):
+    def test_high_nickname_found(self):
+        daemon = FakeDaemon()
+        daemon.replies = who_is_there_replies(daemon, (5, 0xF0))
+        with mock.patch('vscp.util.WHO_IS_THERE_SLOT', SLOT):
+            found = asyncio.run(who_is_there_all(daemon))
+        self.assertEqual(sorted(found), [5, 0xF0])
+        self.assertEqual(found[0xF0][1], 'paris')
+        self.assertEqual(len(daemon.sent), 1)
+
+if __name__ == '__main__':
+    unittest.main()
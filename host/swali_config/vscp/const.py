@@ -16,10 +16,18 @@ EVENT_EXT_PAGE_RESP = 0x27
 EVENT_INFORMATION_ON = 0x03
 EVENT_INFORMATION_OFF = 0x04
 EVENT_INFORMATION_LEVEL = 0x28
+EVENT_INFORMATION_STATE = 0x2A
 
 EVENT_CONTROL_TURN_ON = 0x05
 EVENT_CONTROL_TURN_OFF = 0x06
 EVENT_CHANGE_LEVEL = 0x16
+EVENT_CONTROL_SYNC = 0x1A
+
+# a broadcast WHO_IS_THERE is answered in a time slot per nickname
+WHO_IS_THERE_SLOT = 0.008
+# highest nickname a node can have, 0xFF is the broadcast
+MAX_NICKNAME = 0xFE
+WHO_IS_THERE_FRAMES = 7
 
 STD_REG_UID = 0x84
 STD_REG_PAGES = 0x99
@@ -30,6 +38,12 @@ STD_REG_FW_MICRO = 0x96
 STD_REG_MDF = 0xE0
 STD_REG_GUID = 0xD0
 
+# registers of the VSCP layer of the node itself
+NODE_PAGE = 0x200
+NODE_REG_HEARTBEAT = 0x00
+NODE_REG_DIAG = 0x10
+NODE_DIAG_LENGTH = 19
+
 STD_REG_LENGTH = {STD_REG_STD_DEV : 8,
                   STD_REG_PAGES : 1,
                   STD_REG_UID : 5}
\ No newline at end of file
@@ -30,6 +30,22 @@ class Filter():
     def clear(cls):
         return cls(0, 0x7, 0, 0xffff, 0, 0x1FF, guid.clear(), guid.set())
 
+    @classmethod
+    def union(cls, filters):
+        """A filter passing the events of all filters, and maybe others"""
+        event_class, mask_class = 0, 0x3ff
+        type, mask_type = 0, 0xff
+        for i, flt in enumerate(filters):
+            if i == 0:
+                event_class, type = flt.event_class, flt.type
+            mask_class &= flt.mask_class & ~(event_class ^ flt.event_class)
+            mask_type &= flt.mask_type & ~(type ^ flt.type)
+        return cls(0, 0, event_class & mask_class, mask_class, type & mask_type, mask_type)
+
+    def matches(self, ev):
+        return (((ev.vscp_class ^ self.event_class) & self.mask_class) == 0 and
+                ((ev.vscp_type ^ self.type) & self.mask_type) == 0)
+
     def filter_str(self):
         return f'{self.priority},{self.event_class},{self.type},{self.guid}'
 
@@ -0,0 +1,176 @@
+import asyncio
+import struct
+from .const import (CLASS_VSCP,
+                    EVENT_EXT_PAGE_READ,
+                    EVENT_EXT_PAGE_WRITE,
+                    EVENT_EXT_PAGE_RESP)
+from .filter import Filter
+from .event import Event
+
+class RegTimeout(Exception):
+    pass
+
+class _Regs:
+    """Registers of one node and page waiting for their values"""
+    def __init__(self, nickname, page, reg, num):
+        self.nickname = nickname
+        self.page = page
+        self.reg = reg
+        self.num = num
+        self.data = bytearray(num)
+        self.missing = set(range(num))
+        self.done = asyncio.get_running_loop().create_future()
+
+    def feed(self, reg, data):
+        for i, value in enumerate(data):
+            offset = (reg + i - self.reg) & 0xFF
+            if offset in self.missing:
+                self.data[offset] = value
+                self.missing.discard(offset)
+        if not self.missing and not self.done.done():
+            self.done.set_result(self.data)
+
+class _Request:
+    """One EXTENDED_PAGE_READ or _WRITE and the registers it answers"""
+    def __init__(self, vscp_type, data, regs):
+        self.vscp_type = vscp_type
+        self.data = data
+        self.regs = regs
+
+class RegisterMux:
+    """Register access with many requests in flight.
+
+    The replies (EXTENDED_PAGE_RESPONSE) are taken from the receive loop
+    and matched to the requests by nickname, page and register. Each node
+    has one request in flight, the nodes are served in parallel. Reads of
+    a node queued at the same time are merged into one EXTENDED_PAGE_READ
+    when they are contiguous, or at most gap registers apart.
+
+    The replies come from a subscription to the receive loop of the
+    connection, made on the first request if start() wasn't called.
+    Requests sent while the functions in util poll the daemon are retried."""
+    def __init__(self, vscp, timeout=0.5, retries=2, gap=4):
+        self.vscp = vscp
+        self.timeout = timeout
+        self.retries = retries
+        self.gap = gap
+        self._queued = dict()   # nickname: requests not sent yet
+        self._pending = dict()  # nickname: registers of the request in flight
+        self._workers = dict()  # nickname: task sending the requests
+        self._key = None        # of the subscription to the receive loop
+        self._lock = asyncio.Lock()
+
+    async def __aenter__(self):
+        await self.start()
+        return self
+
+    async def __aexit__(self, *exc):
+        await self.stop()
+
+    async def start(self):
+        async with self._lock:
+            if self._key is None:
+                flt = Filter(0,0,CLASS_VSCP,0x3ff,EVENT_EXT_PAGE_RESP,0xFF)
+                self._key = await self.vscp.subscribe(self._process_event, flt)
+
+    async def stop(self):
+        async with self._lock:
+            if self._key is not None:
+                await self.vscp.unsubscribe(self._key)
+                self._key = None
+
+    async def read(self, nickname, page, reg, num=1):
+        """Read num registers, raises RegTimeout without a reply"""
+        if num == 0:
+            return bytearray()
+        regs = _Regs(nickname, page, reg, num)
+        self._queue(nickname, regs)
+        return await regs.done
+
+    async def write(self, nickname, page, reg, value):
+        """Write up to 4 registers, returns the values read back"""
+        if(len(value) > 4):
+            raise ValueError('Register write limited to 4 bytes')
+        regs = _Regs(nickname, page, reg, len(value))
+        self._queue(nickname, _Request(EVENT_EXT_PAGE_WRITE,
+                                       struct.pack('>BHB', nickname, page, reg) + value,
+                                       [regs]))
+        return await regs.done
+
+    def _queue(self, nickname, item):
+        self._queued.setdefault(nickname, list()).append(item)
+        if nickname not in self._workers:
+            self._workers[nickname] = asyncio.create_task(self._serve(nickname))
+
+    async def _process_event(self, ev):
+        if ev.vscp_type != EVENT_EXT_PAGE_RESP or len(ev.data) < 4:
+            return
+        page = (ev.data[1] << 8) | ev.data[2]
+        for regs in self._pending.get(ev.guid.nickname, ()):
+            if regs.page == page:
+                regs.feed(ev.data[3], ev.data[4:])
+
+    async def _serve(self, nickname):
+        try:
+            while self._queued.get(nickname):
+                await asyncio.sleep(0)  # let the callers queue their reads
+                for request in self._batch(self._queued.pop(nickname)):
+                    await self._send(nickname, request)
+        finally:
+            del self._workers[nickname]
+
+    def _batch(self, items):
+        """Merge the reads between the writes, writes keep their place"""
+        reads = list()
+        for item in items + [None]:
+            if isinstance(item, _Regs):
+                reads.append(item)
+                continue
+            reads.sort(key=lambda r: (r.page, r.reg))
+            while reads:
+                merged = [reads.pop(0)]
+                start = merged[0].reg
+                end = start + merged[0].num
+                while (reads and reads[0].page == merged[0].page and end <= 0x100 and
+                       reads[0].reg <= end + self.gap and
+                       max(end, reads[0].reg + reads[0].num) - start <= 0x100):
+                    end = max(end, reads[0].reg + reads[0].num)
+                    merged.append(reads.pop(0))
+                yield self._read_request(merged)
+            if item is not None:
+                yield item
+
+    @staticmethod
+    def _read_request(regs):
+        start = min(r.reg for r in regs)
+        num = max(r.reg + r.num for r in regs) - start
+        return _Request(EVENT_EXT_PAGE_READ,
+                        struct.pack('>BHBB', regs[0].nickname, regs[0].page, start,
+                                    num & 0xFF),
+                        regs)
+
+    async def _send(self, nickname, request):
+        self._pending[nickname] = request.regs
+        try:
+            for attempt in range(self.retries + 1):
+                waiting = [r.done for r in request.regs if not r.done.done()]
+                if not waiting:
+                    return
+                if attempt and request.vscp_type == EVENT_EXT_PAGE_READ:
+                    # ask again for the registers still missing only
+                    request = self._read_request([r for r in request.regs if not r.done.done()])
+                await self.start()
+                async with self.vscp.listening():
+                    await self.vscp.send(Event(vscp_class=CLASS_VSCP,
+                                               vscp_type=request.vscp_type,
+                                               data=request.data))
+                num = sum(r.num for r in request.regs)
+                await asyncio.wait(waiting, timeout=self.timeout + 0.005 * num)
+            error = RegTimeout('No reply from node {}'.format(nickname))
+        except Exception as e:
+            error = e
+        finally:
+            del self._pending[nickname]
+        for r in request.regs:
+            if not r.done.done():
+                r.done.set_exception(error)
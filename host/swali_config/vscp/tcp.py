@@ -1,5 +1,7 @@
 import asyncio
+import contextlib
 from .event import Event
+from .filter import Filter
 from .const import (DEF_HOST, DEF_PORT, DEF_USER, DEF_PASSWORD)
 
 # internal helpers
@@ -43,6 +45,9 @@ class TCP:
         self.password = password
         self.debuglevel = 0
         self._rcvloop = False
+        self._subscribers = dict() # key: (callback, filter)
+        self._next_key = 0
+        self._loop_lock = asyncio.Lock()
 
     async def connect(self):
         """Connect to a vscpd instance"""
@@ -193,6 +198,59 @@ class TCP:
             pass
         await self._rcvloop_task
 
+    async def subscribe(self, callback, flt=None):
+        """Call the callback for every event passing the filter (all events
+        without one). The receive loop runs while there are subscribers,
+        except in polling(). Returns the key to unsubscribe."""
+        key = self._next_key
+        self._next_key += 1
+        async with self._loop_lock:
+            self._subscribers[key] = (callback, flt)
+            await self._restart_loop()
+        return key
+
+    async def unsubscribe(self, key):
+        async with self._loop_lock:
+            del self._subscribers[key]
+            await self._restart_loop()
+
+    @contextlib.asynccontextmanager
+    async def polling(self):
+        """For the commands which poll the daemon (retr, clrall, ...). The
+        receive loop is stopped and started again for the subscribers after."""
+        async with self._loop_lock:
+            await self.quitloop()
+            try:
+                yield
+            finally:
+                await self._restart_loop()
+
+    @contextlib.asynccontextmanager
+    async def listening(self):
+        """Waits for polling() to finish, to send requests whose replies
+        should reach the subscribers."""
+        async with self._loop_lock:
+            yield
+
+    async def _restart_loop(self):
+        await self.quitloop()
+        if not self._subscribers:
+            return
+        filters = [flt for callback, flt in self._subscribers.values()]
+        if None in filters:
+            flt = Filter(0,0,0,0,0,0)
+        else:
+            flt = Filter.union(filters)
+        await self.setmask(flt)
+        await self.setfilter(flt)
+        await self.clrall()
+        await self.rcvloop(self._dispatch)
+
+    async def _dispatch(self, ev):
+        for callback, flt in list(self._subscribers.values()):
+            if flt is None or flt.matches(ev):
+                await callback(ev)
+
     async def close(self):
         """Close the connection without assuming anything about it."""
         await self.quitloop()
@@ -1,16 +1,32 @@
 import asyncio
 from .const import (CLASS_VSCP,
+                    CLASS_CONTROL,
+                    CLASS_INFORMATION,
+                    EVENT_CONTROL_SYNC,
+                    EVENT_INFORMATION_STATE,
                     EVENT_WHO_IS_THERE,
                     EVENT_WHO_IS_THERE_RESPONSE,
+                    WHO_IS_THERE_SLOT,
+                    WHO_IS_THERE_FRAMES,
+                    MAX_NICKNAME,
                     EVENT_EXT_PAGE_RESP,
                     EVENT_EXT_PAGE_READ,
                     EVENT_EXT_PAGE_WRITE,
-                    STD_REG_LENGTH)
+                    STD_REG_LENGTH,
+                    NODE_PAGE,
+                    NODE_REG_DIAG,
+                    NODE_DIAG_LENGTH)
 from .filter import Filter
 from .event import Event
 from .guid import Guid
 import struct
 
+async def _poll_filter(vscp, flt):
+    # in polling(): only flt passes to the buffer of retr
+    await vscp.setmask(flt)
+    await vscp.setfilter(flt)
+    await vscp.clrall()
+
 async def write_reg(vscp, page, reg, nickname, value):
     if(len(value) > 4):
         raise ValueError('Register write limited to 4 bytes')
@@ -27,20 +43,15 @@ async def read_reg(vscp, nickname, page, reg, num=1):
     else:
         num_cmd = num
 
-    await vscp.quitloop()
-    flt = Filter(0,0,0,0x3ff,EVENT_EXT_PAGE_RESP,0xFF)
-    await vscp.setmask(flt)
-    await vscp.setfilter(flt)
-    await vscp.clrall()
-
     tx_event = Event(vscp_class = CLASS_VSCP,
                      vscp_type  = EVENT_EXT_PAGE_READ,
                      data = struct.pack('>BHBB', nickname, page, reg,num_cmd))
 
-    await vscp.send(tx_event)
-
-    await asyncio.sleep(0.005 * num + 0.01)
-    resp = await vscp.retr(int(num/4)+2)
+    async with vscp.polling():
+        await _poll_filter(vscp, Filter(0,0,0,0x3ff,EVENT_EXT_PAGE_RESP,0xFF))
+        await vscp.send(tx_event)
+        await asyncio.sleep(0.005 * num + 0.01)
+        resp = await vscp.retr(int(num/4)+2)
     resp = [x for x in resp[1] if x.guid.nickname == nickname]
     result=bytearray(num_cmd)
     for item in resp:
@@ -50,32 +61,109 @@ async def read_reg(vscp, nickname, page, reg, num=1):
 async def read_std_reg(vscp, nickname, reg):
     return await read_reg(vscp, nickname, 0, reg, STD_REG_LENGTH[reg])
 
+async def read_diagnostics(vscp, nickname):
+    """Read the bus and health counters of a node in one page read."""
+    raw = await read_reg(vscp, nickname, NODE_PAGE, NODE_REG_DIAG,
+                         NODE_DIAG_LENGTH)
+    values = struct.unpack('>IIHBBBBBHH', raw)
+    return dict(zip(('rx_frames', 'tx_frames', 'tx_retries', 'rx_overflows',
+                     'error_passive', 'bus_off', 'tx_error_count',
+                     'rx_error_count', 'loop_max_ms', 'eeprom_writes'),
+                    values))
+
+def _add_frames(frames, events):
+    """Sort WHO_IS_THERE_RESPONSE frames by nickname and index"""
+    for ev in events:
+        if len(ev.data) == 8 and ev.data[0] < WHO_IS_THERE_FRAMES:
+            frames.setdefault(ev.guid.nickname, dict())[ev.data[0]] = ev.data[1:]
+
+def _identify(frames):
+    """GUID and MDF name from all frames of a node"""
+    # assemble all the data in order
+    raw = bytearray(7 * WHO_IS_THERE_FRAMES)
+    for index, data in frames.items():
+        raw[index * 7:index * 7 + 7] = data
+
+    guid = Guid(bytes([byte for byte in reversed(raw[0:16])]))
+    mdf = raw[16:].split(b'\0')[0].decode()
+    return guid, mdf
+
 async def who_is_there(vscp, nickname):
     guid = None
     mdf  = None
 
-    await vscp.quitloop()
-    flt = Filter(0,0,0,0x3ff,EVENT_WHO_IS_THERE_RESPONSE,0xFF)
-    await vscp.setmask(flt)
-    await vscp.setfilter(flt)
-    await vscp.clrall()
+    async with vscp.polling():
+        await _poll_filter(vscp, Filter(0,0,0,0x3ff,EVENT_WHO_IS_THERE_RESPONSE,0xFF))
+        await vscp.send(Event(vscp_class=0, vscp_type=EVENT_WHO_IS_THERE,
+                              data=struct.pack('>B', nickname)))
+        await asyncio.sleep(0.01)  # allow time for replies & spare bandwidth
+        resp = await vscp.retr(100)
 
-    await vscp.send(Event(vscp_class=0, vscp_type=EVENT_WHO_IS_THERE,
-                          data=struct.pack('>B', nickname)))
-    await asyncio.sleep(0.01)  # allow time for replies & spare bandwidth
-    resp = await vscp.retr(100)
+    frames = dict()
+    _add_frames(frames, resp[1])
 
-    filtered = [x for x in resp[1] if x.guid.nickname == nickname]
+    if len(frames.get(nickname, ())) == WHO_IS_THERE_FRAMES:
+        guid, mdf = _identify(frames[nickname])
 
-    if len(filtered) == 7:
-        # assemble all the data in order
-        raw = bytearray(7 * 7)
-        for ev in filtered:
-            if len(ev.data) == 8:
-                offset = int(ev.data[0]) * 7
-                raw[offset:offset + 7] = ev.data[1:]
+    return guid, mdf
 
-        guid = Guid(bytes([byte for byte in reversed(raw[0:16])]))
-        mdf = raw[16:].split(b'\0')[0].decode()
+async def who_is_there_all(vscp, nicknames=MAX_NICKNAME + 1, retries=2):
+    """Identify all nodes with one broadcast WHO_IS_THERE. The nodes answer
+    in the slot of their nickname, so the first round waits for the slot
+    of the highest nickname. The nodes with lost frames are asked again
+    all at once. Returns {nickname: (guid, mdf)}."""
+    frames = dict()
+    async with vscp.polling():
+        await _poll_filter(vscp, Filter(0,0,0,0x3ff,EVENT_WHO_IS_THERE_RESPONSE,0xFF))
+        await vscp.send(Event(vscp_class=0, vscp_type=EVENT_WHO_IS_THERE,
+                              data=struct.pack('>B', 0xFF)))
+        await _collect(vscp, frames, nicknames * WHO_IS_THERE_SLOT + 0.1)
 
-    return guid, mdf
+        for attempt in range(retries):
+            incomplete = [n for n, f in frames.items() if len(f) < WHO_IS_THERE_FRAMES]
+            if not incomplete:
+                break
+            for nickname in incomplete:
+                await vscp.send(Event(vscp_class=0, vscp_type=EVENT_WHO_IS_THERE,
+                                      data=struct.pack('>B', nickname)))
+            await _collect(vscp, frames, len(incomplete) * WHO_IS_THERE_SLOT + 0.05)
+
+    return {n: _identify(f) for n, f in sorted(frames.items())
+            if len(f) == WHO_IS_THERE_FRAMES}
+
+async def _collect(vscp, frames, duration):
+    # fetch the frames while they come in, the buffer of the daemon is limited
+    deadline = asyncio.get_running_loop().time() + duration
+    while True:
+        await asyncio.sleep(0.1)
+        resp = await vscp.retr(512)
+        _add_frames(frames, resp[1])
+        if asyncio.get_running_loop().time() >= deadline:
+            break
+
+async def read_states(vscp, nickname=0xFF):
+    """Read the state of all channels of a node, or of all nodes with the
+    default broadcast nickname. Returns {nickname: {channel: state}} where
+    state is 0 = off, 1 = on, 2 = flashing."""
+    async with vscp.polling():
+        await _poll_filter(vscp, Filter(0,0,CLASS_INFORMATION,0x3ff,EVENT_INFORMATION_STATE,0xFF))
+        await vscp.send(Event(vscp_class=CLASS_CONTROL, vscp_type=EVENT_CONTROL_SYNC,
+                              data=struct.pack('>BBB', nickname, 255, 255)))
+        # broadcast replies are spread over 2ms per nickname
+        await asyncio.sleep(0.6 if nickname == 0xFF else 0.05)
+        resp = await vscp.retr(512)
+
+    states = dict()
+    for ev in resp[1]:
+        if ev.vscp_class != CLASS_INFORMATION or len(ev.data) != 6:
+            continue
+        if nickname != 0xFF and ev.guid.nickname != nickname:
+            continue
+        node = states.setdefault(ev.guid.nickname, dict())
+        for bit in range(8):
+            if ev.data[3] & (1 << bit):
+                state = 1 if ev.data[4] & (1 << bit) else 0
+                if ev.data[5] & (1 << bit):
+                    state = 2
+                node[ev.data[0] + bit] = state
+    return states
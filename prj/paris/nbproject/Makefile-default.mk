@@ -57,17 +57,17 @@ OBJECTDIR=build/${CND_CONF}/${IMAGE_TYPE}
 DISTDIR=dist/${CND_CONF}/${IMAGE_TYPE}
 
 # Source Files Quoted if spaced
-SOURCEFILES_QUOTED_IF_SPACED=../../src/paris/main.c ../../src/common/pic/can.c ../../src/common/pic/configuration.c ../../src/common/pic/systick.c ../../src/common/pic/pic_swali.c ../../src/common/pic/ecan.c ../../src/common/swali/swali.c ../../src/common/swali/swali_output.c ../../src/common/util/led.c ../../src/common/util/time.c ../../src/common/vscp/vscp.c
+SOURCEFILES_QUOTED_IF_SPACED=../../src/paris/main.c ../../src/common/pic/can.c ../../src/common/pic/configuration.c ../../src/common/pic/systick.c ../../src/common/pic/pic_swali.c ../../src/common/pic/ecan.c ../../src/common/pic/pwm.c ../../src/common/swali/swali.c ../../src/common/swali/swali_output.c ../../src/common/swali/swali_dm.c ../../src/common/swali/swali_timer.c ../../src/common/util/led.c ../../src/common/util/time.c ../../src/common/vscp/vscp.c
 
 # Object Files Quoted if spaced
-OBJECTFILES_QUOTED_IF_SPACED=${OBJECTDIR}/_ext/711835648/main.p1 ${OBJECTDIR}/_ext/1941071377/can.p1 ${OBJECTDIR}/_ext/1941071377/configuration.p1 ${OBJECTDIR}/_ext/1941071377/systick.p1 ${OBJECTDIR}/_ext/1941071377/pic_swali.p1 ${OBJECTDIR}/_ext/1941071377/ecan.p1 ${OBJECTDIR}/_ext/1356976001/swali.p1 ${OBJECTDIR}/_ext/1356976001/swali_output.p1 ${OBJECTDIR}/_ext/43830363/led.p1 ${OBJECTDIR}/_ext/43830363/time.p1 ${OBJECTDIR}/_ext/43859011/vscp.p1
-POSSIBLE_DEPFILES=${OBJECTDIR}/_ext/711835648/main.p1.d ${OBJECTDIR}/_ext/1941071377/can.p1.d ${OBJECTDIR}/_ext/1941071377/configuration.p1.d ${OBJECTDIR}/_ext/1941071377/systick.p1.d ${OBJECTDIR}/_ext/1941071377/pic_swali.p1.d ${OBJECTDIR}/_ext/1941071377/ecan.p1.d ${OBJECTDIR}/_ext/1356976001/swali.p1.d ${OBJECTDIR}/_ext/1356976001/swali_output.p1.d ${OBJECTDIR}/_ext/43830363/led.p1.d ${OBJECTDIR}/_ext/43830363/time.p1.d ${OBJECTDIR}/_ext/43859011/vscp.p1.d
+OBJECTFILES_QUOTED_IF_SPACED=${OBJECTDIR}/_ext/711835648/main.p1 ${OBJECTDIR}/_ext/1941071377/can.p1 ${OBJECTDIR}/_ext/1941071377/configuration.p1 ${OBJECTDIR}/_ext/1941071377/systick.p1 ${OBJECTDIR}/_ext/1941071377/pic_swali.p1 ${OBJECTDIR}/_ext/1941071377/ecan.p1 ${OBJECTDIR}/_ext/1941071377/pwm.p1 ${OBJECTDIR}/_ext/1356976001/swali.p1 ${OBJECTDIR}/_ext/1356976001/swali_output.p1 ${OBJECTDIR}/_ext/1356976001/swali_dm.p1 ${OBJECTDIR}/_ext/1356976001/swali_timer.p1 ${OBJECTDIR}/_ext/43830363/led.p1 ${OBJECTDIR}/_ext/43830363/time.p1 ${OBJECTDIR}/_ext/43859011/vscp.p1
+POSSIBLE_DEPFILES=${OBJECTDIR}/_ext/711835648/main.p1.d ${OBJECTDIR}/_ext/1941071377/can.p1.d ${OBJECTDIR}/_ext/1941071377/configuration.p1.d ${OBJECTDIR}/_ext/1941071377/systick.p1.d ${OBJECTDIR}/_ext/1941071377/pic_swali.p1.d ${OBJECTDIR}/_ext/1941071377/ecan.p1.d ${OBJECTDIR}/_ext/1941071377/pwm.p1.d ${OBJECTDIR}/_ext/1356976001/swali.p1.d ${OBJECTDIR}/_ext/1356976001/swali_output.p1.d ${OBJECTDIR}/_ext/1356976001/swali_dm.p1.d ${OBJECTDIR}/_ext/1356976001/swali_timer.p1.d ${OBJECTDIR}/_ext/43830363/led.p1.d ${OBJECTDIR}/_ext/43830363/time.p1.d ${OBJECTDIR}/_ext/43859011/vscp.p1.d
 
 # Object Files
-OBJECTFILES=${OBJECTDIR}/_ext/711835648/main.p1 ${OBJECTDIR}/_ext/1941071377/can.p1 ${OBJECTDIR}/_ext/1941071377/configuration.p1 ${OBJECTDIR}/_ext/1941071377/systick.p1 ${OBJECTDIR}/_ext/1941071377/pic_swali.p1 ${OBJECTDIR}/_ext/1941071377/ecan.p1 ${OBJECTDIR}/_ext/1356976001/swali.p1 ${OBJECTDIR}/_ext/1356976001/swali_output.p1 ${OBJECTDIR}/_ext/43830363/led.p1 ${OBJECTDIR}/_ext/43830363/time.p1 ${OBJECTDIR}/_ext/43859011/vscp.p1
+OBJECTFILES=${OBJECTDIR}/_ext/711835648/main.p1 ${OBJECTDIR}/_ext/1941071377/can.p1 ${OBJECTDIR}/_ext/1941071377/configuration.p1 ${OBJECTDIR}/_ext/1941071377/systick.p1 ${OBJECTDIR}/_ext/1941071377/pic_swali.p1 ${OBJECTDIR}/_ext/1941071377/ecan.p1 ${OBJECTDIR}/_ext/1941071377/pwm.p1 ${OBJECTDIR}/_ext/1356976001/swali.p1 ${OBJECTDIR}/_ext/1356976001/swali_output.p1 ${OBJECTDIR}/_ext/1356976001/swali_dm.p1 ${OBJECTDIR}/_ext/1356976001/swali_timer.p1 ${OBJECTDIR}/_ext/43830363/led.p1 ${OBJECTDIR}/_ext/43830363/time.p1 ${OBJECTDIR}/_ext/43859011/vscp.p1
 
 # Source Files
-SOURCEFILES=../../src/paris/main.c ../../src/common/pic/can.c ../../src/common/pic/configuration.c ../../src/common/pic/systick.c ../../src/common/pic/pic_swali.c ../../src/common/pic/ecan.c ../../src/common/swali/swali.c ../../src/common/swali/swali_output.c ../../src/common/util/led.c ../../src/common/util/time.c ../../src/common/vscp/vscp.c
+SOURCEFILES=../../src/paris/main.c ../../src/common/pic/can.c ../../src/common/pic/configuration.c ../../src/common/pic/systick.c ../../src/common/pic/pic_swali.c ../../src/common/pic/ecan.c ../../src/common/pic/pwm.c ../../src/common/swali/swali.c ../../src/common/swali/swali_output.c ../../src/common/swali/swali_dm.c ../../src/common/swali/swali_timer.c ../../src/common/util/led.c ../../src/common/util/time.c ../../src/common/vscp/vscp.c
 
 
 
@@ -142,6 +142,14 @@ ${OBJECTDIR}/_ext/1941071377/ecan.p1: ../../src/common/pic/ecan.c  nbproject/Mak
 	@-${MV} ${OBJECTDIR}/_ext/1941071377/ecan.d ${OBJECTDIR}/_ext/1941071377/ecan.p1.d 
 	@${FIXDEPS} ${OBJECTDIR}/_ext/1941071377/ecan.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
 	
+${OBJECTDIR}/_ext/1941071377/pwm.p1: ../../src/common/pic/pwm.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/_ext/1941071377" 
+	@${RM} ${OBJECTDIR}/_ext/1941071377/pwm.p1.d 
+	@${RM} ${OBJECTDIR}/_ext/1941071377/pwm.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  -D__DEBUG=1  --debugger=icd3  --double=24 --float=24 --emi=wordwrite --rom=default,-1000-1003 --opt=+asm,+asmfile,-speed,+space,-debug --addrqual=ignore --mode=pro -D_PLIB -P -N255 -I"../../src/paris" -I"../../src/common/pic" -I"../../src/common/swali" -I"../../src/common/util" -I"../../src/common/vscp" --warn=-3 --asmlist -DXPRJ_default=$(CND_CONF)  --summary=default,-psect,-class,+mem,-hex,+file --html ${opt-xc8-linker-serial.prefix}--serial=00000000@1000 --codeoffset=0x800 --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-download,+config,+clib,+plib $(COMPARISON_BUILD)  --output=-mcof,+elf:multilocs --stack=compiled:auto:auto:auto "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"     -o${OBJECTDIR}/_ext/1941071377/pwm.p1 ../../src/common/pic/pwm.c 
+	@-${MV} ${OBJECTDIR}/_ext/1941071377/pwm.d ${OBJECTDIR}/_ext/1941071377/pwm.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/_ext/1941071377/pwm.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
 ${OBJECTDIR}/_ext/1356976001/swali.p1: ../../src/common/swali/swali.c  nbproject/Makefile-${CND_CONF}.mk
 	@${MKDIR} "${OBJECTDIR}/_ext/1356976001" 
 	@${RM} ${OBJECTDIR}/_ext/1356976001/swali.p1.d 
@@ -158,6 +166,22 @@ ${OBJECTDIR}/_ext/1356976001/swali_output.p1: ../../src/common/swali/swali_outpu
 	@-${MV} ${OBJECTDIR}/_ext/1356976001/swali_output.d ${OBJECTDIR}/_ext/1356976001/swali_output.p1.d 
 	@${FIXDEPS} ${OBJECTDIR}/_ext/1356976001/swali_output.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
 	
+${OBJECTDIR}/_ext/1356976001/swali_dm.p1: ../../src/common/swali/swali_dm.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/_ext/1356976001" 
+	@${RM} ${OBJECTDIR}/_ext/1356976001/swali_dm.p1.d 
+	@${RM} ${OBJECTDIR}/_ext/1356976001/swali_dm.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  -D__DEBUG=1  --debugger=icd3  --double=24 --float=24 --emi=wordwrite --rom=default,-1000-1003 --opt=+asm,+asmfile,-speed,+space,-debug --addrqual=ignore --mode=pro -D_PLIB -P -N255 -I"../../src/paris" -I"../../src/common/pic" -I"../../src/common/swali" -I"../../src/common/util" -I"../../src/common/vscp" --warn=-3 --asmlist -DXPRJ_default=$(CND_CONF)  --summary=default,-psect,-class,+mem,-hex,+file --html ${opt-xc8-linker-serial.prefix}--serial=00000000@1000 --codeoffset=0x800 --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-download,+config,+clib,+plib $(COMPARISON_BUILD)  --output=-mcof,+elf:multilocs --stack=compiled:auto:auto:auto "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"     -o${OBJECTDIR}/_ext/1356976001/swali_dm.p1 ../../src/common/swali/swali_dm.c 
+	@-${MV} ${OBJECTDIR}/_ext/1356976001/swali_dm.d ${OBJECTDIR}/_ext/1356976001/swali_dm.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/_ext/1356976001/swali_dm.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
+${OBJECTDIR}/_ext/1356976001/swali_timer.p1: ../../src/common/swali/swali_timer.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/_ext/1356976001" 
+	@${RM} ${OBJECTDIR}/_ext/1356976001/swali_timer.p1.d 
+	@${RM} ${OBJECTDIR}/_ext/1356976001/swali_timer.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  -D__DEBUG=1  --debugger=icd3  --double=24 --float=24 --emi=wordwrite --rom=default,-1000-1003 --opt=+asm,+asmfile,-speed,+space,-debug --addrqual=ignore --mode=pro -D_PLIB -P -N255 -I"../../src/paris" -I"../../src/common/pic" -I"../../src/common/swali" -I"../../src/common/util" -I"../../src/common/vscp" --warn=-3 --asmlist -DXPRJ_default=$(CND_CONF)  --summary=default,-psect,-class,+mem,-hex,+file --html ${opt-xc8-linker-serial.prefix}--serial=00000000@1000 --codeoffset=0x800 --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-download,+config,+clib,+plib $(COMPARISON_BUILD)  --output=-mcof,+elf:multilocs --stack=compiled:auto:auto:auto "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"     -o${OBJECTDIR}/_ext/1356976001/swali_timer.p1 ../../src/common/swali/swali_timer.c 
+	@-${MV} ${OBJECTDIR}/_ext/1356976001/swali_timer.d ${OBJECTDIR}/_ext/1356976001/swali_timer.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/_ext/1356976001/swali_timer.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
 ${OBJECTDIR}/_ext/43830363/led.p1: ../../src/common/util/led.c  nbproject/Makefile-${CND_CONF}.mk
 	@${MKDIR} "${OBJECTDIR}/_ext/43830363" 
 	@${RM} ${OBJECTDIR}/_ext/43830363/led.p1.d 
@@ -231,6 +255,14 @@ ${OBJECTDIR}/_ext/1941071377/ecan.p1: ../../src/common/pic/ecan.c  nbproject/Mak
 	@-${MV} ${OBJECTDIR}/_ext/1941071377/ecan.d ${OBJECTDIR}/_ext/1941071377/ecan.p1.d 
 	@${FIXDEPS} ${OBJECTDIR}/_ext/1941071377/ecan.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
 	
+${OBJECTDIR}/_ext/1941071377/pwm.p1: ../../src/common/pic/pwm.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/_ext/1941071377" 
+	@${RM} ${OBJECTDIR}/_ext/1941071377/pwm.p1.d 
+	@${RM} ${OBJECTDIR}/_ext/1941071377/pwm.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  --double=24 --float=24 --emi=wordwrite --rom=default,-1000-1003 --opt=+asm,+asmfile,-speed,+space,-debug --addrqual=ignore --mode=pro -D_PLIB -P -N255 -I"../../src/paris" -I"../../src/common/pic" -I"../../src/common/swali" -I"../../src/common/util" -I"../../src/common/vscp" --warn=-3 --asmlist -DXPRJ_default=$(CND_CONF)  --summary=default,-psect,-class,+mem,-hex,+file --html ${opt-xc8-linker-serial.prefix}--serial=00000000@1000 --codeoffset=0x800 --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-download,+config,+clib,+plib $(COMPARISON_BUILD)  --output=-mcof,+elf:multilocs --stack=compiled:auto:auto:auto "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"     -o${OBJECTDIR}/_ext/1941071377/pwm.p1 ../../src/common/pic/pwm.c 
+	@-${MV} ${OBJECTDIR}/_ext/1941071377/pwm.d ${OBJECTDIR}/_ext/1941071377/pwm.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/_ext/1941071377/pwm.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
 ${OBJECTDIR}/_ext/1356976001/swali.p1: ../../src/common/swali/swali.c  nbproject/Makefile-${CND_CONF}.mk
 	@${MKDIR} "${OBJECTDIR}/_ext/1356976001" 
 	@${RM} ${OBJECTDIR}/_ext/1356976001/swali.p1.d 
@@ -247,6 +279,22 @@ ${OBJECTDIR}/_ext/1356976001/swali_output.p1: ../../src/common/swali/swali_outpu
 	@-${MV} ${OBJECTDIR}/_ext/1356976001/swali_output.d ${OBJECTDIR}/_ext/1356976001/swali_output.p1.d 
 	@${FIXDEPS} ${OBJECTDIR}/_ext/1356976001/swali_output.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
 	
+${OBJECTDIR}/_ext/1356976001/swali_dm.p1: ../../src/common/swali/swali_dm.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/_ext/1356976001" 
+	@${RM} ${OBJECTDIR}/_ext/1356976001/swali_dm.p1.d 
+	@${RM} ${OBJECTDIR}/_ext/1356976001/swali_dm.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  --double=24 --float=24 --emi=wordwrite --rom=default,-1000-1003 --opt=+asm,+asmfile,-speed,+space,-debug --addrqual=ignore --mode=pro -D_PLIB -P -N255 -I"../../src/paris" -I"../../src/common/pic" -I"../../src/common/swali" -I"../../src/common/util" -I"../../src/common/vscp" --warn=-3 --asmlist -DXPRJ_default=$(CND_CONF)  --summary=default,-psect,-class,+mem,-hex,+file --html ${opt-xc8-linker-serial.prefix}--serial=00000000@1000 --codeoffset=0x800 --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-download,+config,+clib,+plib $(COMPARISON_BUILD)  --output=-mcof,+elf:multilocs --stack=compiled:auto:auto:auto "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"     -o${OBJECTDIR}/_ext/1356976001/swali_dm.p1 ../../src/common/swali/swali_dm.c 
+	@-${MV} ${OBJECTDIR}/_ext/1356976001/swali_dm.d ${OBJECTDIR}/_ext/1356976001/swali_dm.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/_ext/1356976001/swali_dm.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
+${OBJECTDIR}/_ext/1356976001/swali_timer.p1: ../../src/common/swali/swali_timer.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/_ext/1356976001" 
+	@${RM} ${OBJECTDIR}/_ext/1356976001/swali_timer.p1.d 
+	@${RM} ${OBJECTDIR}/_ext/1356976001/swali_timer.p1 
+	${MP_CC} --pass1 $(MP_EXTRA_CC_PRE) --chip=$(MP_PROCESSOR_OPTION) -Q -G  --double=24 --float=24 --emi=wordwrite --rom=default,-1000-1003 --opt=+asm,+asmfile,-speed,+space,-debug --addrqual=ignore --mode=pro -D_PLIB -P -N255 -I"../../src/paris" -I"../../src/common/pic" -I"../../src/common/swali" -I"../../src/common/util" -I"../../src/common/vscp" --warn=-3 --asmlist -DXPRJ_default=$(CND_CONF)  --summary=default,-psect,-class,+mem,-hex,+file --html ${opt-xc8-linker-serial.prefix}--serial=00000000@1000 --codeoffset=0x800 --output=default,-inhx032 --runtime=default,+clear,+init,-keep,-no_startup,-download,+config,+clib,+plib $(COMPARISON_BUILD)  --output=-mcof,+elf:multilocs --stack=compiled:auto:auto:auto "--errformat=%f:%l: error: (%n) %s" "--warnformat=%f:%l: warning: (%n) %s" "--msgformat=%f:%l: advisory: (%n) %s"     -o${OBJECTDIR}/_ext/1356976001/swali_timer.p1 ../../src/common/swali/swali_timer.c 
+	@-${MV} ${OBJECTDIR}/_ext/1356976001/swali_timer.d ${OBJECTDIR}/_ext/1356976001/swali_timer.p1.d 
+	@${FIXDEPS} ${OBJECTDIR}/_ext/1356976001/swali_timer.p1.d $(SILENT) -rsi ${MP_CC_DIR}../  
+	
 ${OBJECTDIR}/_ext/43830363/led.p1: ../../src/common/util/led.c  nbproject/Makefile-${CND_CONF}.mk
 	@${MKDIR} "${OBJECTDIR}/_ext/43830363" 
 	@${RM} ${OBJECTDIR}/_ext/43830363/led.p1.d 
@@ -25,6 +25,8 @@ extern "C" {
 #define SWALI_NUM_INPUTS 10
 #define SWALI_NUM_OUTPUTS 0
 #define SWALI_NAME_LENGTH 16  // number of characters to store for outputs
+#define SWALI_NUM_SCENES 0    // no outputs to drive
+#define SWALI_NUM_DM_ROWS 0   // no outputs to drive
     
 #ifdef	__cplusplus
 }
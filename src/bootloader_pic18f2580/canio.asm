@@ -73,13 +73,14 @@
 ;* XXXXXXXXXXX 0 0 0 XXXXXXXX XXXXXX11 _NA__ _NA__ _NA__ _NA__ _NA__ _NA__ _NA__ _NA__
 ;*
 ;* Put commands sent upon receiving Get command  (Slave --> Master)
-;* YYYYYYYYYYY 0 0 8 YYYYYYYY YYYYYY00 ADDRL ADDRH ADDRU RESVD STATS RESVD RESVD RESVD
+;* YYYYYYYYYYY 0 0 8 YYYYYYYY YYYYYY00 ADDRL ADDRH ADDRU ERRST CTLBT SPCMD CHKSL CHKSH
 ;* YYYYYYYYYYY 0 0 8 YYYYYYYY YYYYYY01 DATA0 DATA1 DATA2 DATA3 DATA4 DATA5 DATA6 DATA7
 ;*
 ;* Put commands sent upon receiving Put command (if enabled) (Slave --> Master)
-;* This is the acknowledge after a put.
-;* YYYYYYYYYYY 0 0 0 YYYYYYYY YYYYYY00 _NA__ _NA__ _NA__ _NA__ _NA__ _NA__ _NA__ _NA__
-;* YYYYYYYYYYY 0 0 0 YYYYYYYY YYYYYY01 _NA__ _NA__ _NA__ _NA__ _NA__ _NA__ _NA__ _NA__
+;* This is the acknowledge after a put. It holds the memory pointer after
+;* the put, so the source can check which put it belongs to.
+;* YYYYYYYYYYY 0 0 3 YYYYYYYY YYYYYY00 ADDRL ADDRH ADDRU
+;* YYYYYYYYYYY 0 0 3 YYYYYYYY YYYYYY01 ADDRL ADDRH ADDRU
 ;*
 ;* ADDRL - Bits 0 to 7 of the memory pointer.  
 ;* ADDRH - Bits 8 - 15 of the memory pointer.
@@ -90,6 +91,19 @@
 ;* CPDTL - Bits 0 - 7 of special command data.
 ;* CPDTH - Bits 8 - 15 of special command data.
 ;* DATAX - General data.
+;* ERRST - Error status, bit 0 verify failed, bit 1 data put lost (MODE_SEQ),
+;*         bit 2 plain put to program memory that isn't one whole write block
+;*         (not written, acknowledged with the unchanged pointer), bit 7 set if
+;*         packed puts (MODE_PACK) are supported.
+;* CHKSL - Bits 0 - 7 of the running checksum.
+;* CHKSH - Bits 8 - 15 of the running checksum.
+;*
+;* Control commands with a nickname in the low byte of the ID (EIDL) are only
+;* handled by that node, with zero they are handled by all nodes in boot mode.
+;* Data commands go to all nodes, so one stream can program several nodes
+;* (multicast). With MODE_SEQ and without MODE_ACK a node can't resync, so
+;* it drops the rest of the stream after a lost put until its control 
+;* registers are written again.
 ;*
 ;* Control bits:
 ;* ------------
@@ -99,14 +113,56 @@
 ;* Bit 2: MODE_AUTO_ERASE 	-	Set this to automatically erase Program Memory while writing data.
 ;* Bit 3: MODE_AUTO_INC 	-	Set this to automatically increment the pointer after writing.
 ;* Bit 4: MODE_ACK          -	Set this to generate an acknowledge after a 'put' (PG Mode only)
+;* Bit 5: MODE_SEQ          -	Set this to check the sequence of data puts: the low byte
+;*                              of the source address in the ID (EIDL) must equal ADDRL.
+;*                              Puts out of sequence aren't written but acknowledged
+;*                              with the unchanged pointer. This allows the source to
+;*                              send the next put before the previous one is acknowledged.
+;* Bit 6: MODE_MUTE         -	Set this to ignore data puts, for nodes that don't take part
+;*                              in a multicast stream.
+;* Bit 7: MODE_PACK         -	Set this to decode data puts as a packed stream (see
+;*                              CMD_PACK). ADDR is then the position in the stream,
+;*                              for the sequence check and the acknowledge.
 ;*
 ;* Special Commands:
 ;* ----------------
 ;* CMD_NOP			0x00	Do nothing
 ;* CMD_RESET		0x01	Issue a soft reset
-;* CMD_RST_CHKSM	0x02	Reset the checksum counter and verify
+;* CMD_RST_CHKSM	0x02	Reset the checksum counter and the verify and alignment errors
 ;* CMD_CHK_RUN		0x03	Add checksum to special data, if verify and zero checksum
 ;* 							then clear first location of EEDATA.
+;* CMD_CRC32		0x04	Send the CRC32 (IEEE 802.3) of the number of bytes in the special
+;*							data, starting at the pointer. The response holds the CRC, LSB
+;*							first. The pointer isn't changed (PG Mode only).
+;* YYYYYYYYYYY 0 0 4 YYYYYYYY YYYYYY00 CRC_0 CRC_1 CRC_2 CRC_3
+;* CMD_PACK		0x05	Start a packed stream that is written from the pointer (ALLOW_PACK).
+;*							In the stream a control byte c is followed by:
+;*							0x00-0x7F	c+1 bytes that are written as they are,
+;*							0x80-0xBF	one byte that is written c-0x7D times,
+;*							0xC0-0xFF	a distance d (2 bytes, LSB first), c-0xBD
+;*										bytes are copied from d bytes back.
+;*							A copy reads program memory that is already written,
+;*							so d is at least 8 and copies are only used in
+;*							program memory. The written data must be whole write
+;*							blocks of 8 bytes in program memory.
+;*							Control puts without CMD_PACK keep the position in the 
+;*							stream, so a source can resync as with plain puts.
+;*							CMD_PACK is always acknowledged.
+;*
+;* Rollback (AB_SLOTS in canio.def):
+;* --------------------------------
+;* The application area is split in slot A (the running image, from RESET_VECT)
+;* and slot B (a copy of the last image that passed CMD_CHK_RUN). After the 
+;* boot flag is cleared CMD_CHK_RUN copies slot A to slot B and seals it with
+;* its CRC32 in the descriptor row at AB_DESC, which takes a few seconds. 
+;* PIC18 code isn't position independent, so slot B is never run in place.
+;* If a node in boot mode hears no protocol (class 0) frame for AB_TIMEOUT and
+;* slot B is sealed and matches its CRC, slot B is copied back to slot A and the
+;* node is reset into the application. Other nodes being upgraded, their
+;* acknowledges and the host polling the bus all keep the count from running
+;* out. A node without a sealed slot B keeps waiting as before. Each slot
+;* gets half of the application area, so this is mostly of use on parts
+;* with 64K.
 
 ;* Memory Organization:
 ;*				|-------------------------------|
@@ -147,6 +203,9 @@
 ;*				|								| (Last byte used as boot flag)
 ;*				|-------------------------------|
 ;*
+;* With AB_SLOTS Prog Mem is RESET_VECT - AB_SLOT_B slot A, AB_SLOT_B - AB_DESC 
+;* slot B and AB_DESC the rollback descriptor (CRC_0-CRC_3, 0x00 when sealed).
+;*
 ;* PIC18F2580 0x7fff (32K) total memory (2K or 4K bootloader)
 ;* Bootloader is 512 bytes and fit in 2K bootloader block so offset code with
 ;* 0x7ff(2K) or 0xfff(4K)
@@ -308,6 +367,9 @@
 #define		MODE_AUTO_ERASE         _bootCtlBits,2	; Enable auto erase before write
 #define		MODE_AUTO_INC           _bootCtlBits,3	; Enable auto inc the address
 #define		MODE_ACK                _bootCtlBits,4	; Acknowledge mode
+#define		MODE_SEQ                _bootCtlBits,5	; Sequence checked data puts
+#define		MODE_MUTE               _bootCtlBits,6	; Ignore data puts
+#define		MODE_PACK               _bootCtlBits,7	; Decode data puts
 
 ; AKHE
 #define		MODE_FLAG_WRT_UNLCK		0x01
@@ -315,13 +377,28 @@
 #define		MODE_FLAG_AUTO_ERASE	0x04
 #define		MODE_FLAG_AUTO_INC		0x08
 #define		MODE_FLAG_ACK			0x10
+#define		MODE_FLAG_SEQ			0x20
+#define		MODE_FLAG_MUTE			0x40
+#define		MODE_FLAG_PACK			0x80
+
+; CANCON window bits (mode 0) mapping a receive buffer on the RXB0 registers
+#define		CAN_WIN_RXB0			b'00000000'
+#define		CAN_WIN_RXB1			b'00001010'
 
 #define		ERR_VERIFY              _bootErrStat,0	; Failed to verify 
+#define		ERR_SEQ                 _bootErrStat,1	; Lost a sequence checked put
+#define		ERR_ALIGN               _bootErrStat,2	; Put not on a write block
+#define		CAP_PACK                _bootErrStat,7	; Packed puts are supported
+#define		PACK_ARG                _packFlags,0	; Operand of a run or copy next
+#define		PACK_COPY               _packFlags,1	; Decoding a copy
+#define		PACK_DIST               _packFlags,2	; Low byte of the distance is in
 
 #define		CMD_NOP					0x00
 #define		CMD_RESET				0x01
 #define		CMD_RST_CHKSM			0x02
 #define		CMD_CHK_RUN				0x03
+#define		CMD_CRC32				0x04
+#define		CMD_PACK				0x05
 ; *****************************************************************************
 
 
@@ -347,6 +424,38 @@ _bootErrStat	RES	1				; Error Status flags
 
 _vscpNickname	RES	1				; VSCP Nickname - AKHE
 
+_bootWin		RES	1				; CANCON window of the last receive buffer
+
+_bootCrc0		RES	1				; CRC32 of CMD_CRC32
+_bootCrc1		RES	1
+_bootCrc2		RES	1
+_bootCrc3		RES	1
+
+#ifdef	ALLOW_PACK
+_packAddrL		RES	1				; Write pointer of the packed stream
+_packAddrH		RES	1
+_packAddrU		RES	1
+_packCnt		RES	1				; Bytes left in a literal, run or copy
+_packFlags		RES	1
+_packVal		RES	1				; Byte of the run, low byte of the distance
+_packFill		RES	1				; Bytes in the write block
+_packSrcL		RES	1				; Source of a copy
+_packSrcH		RES	1
+_packSrcU		RES	1
+_packBuf		RES	8				; Write block
+#endif
+
+#ifdef	AB_SLOTS
+_abIdle			RES	1				; Silence count, zero when not armed
+_abSrcL			RES	1				; Slot copy source
+_abSrcH			RES	1
+_abDstL			RES	1				; Slot copy destination
+_abDstH			RES	1
+_abCountL		RES	1				; Slot copy and CRC count
+_abCountH		RES	1
+_abBuf			RES	8				; One write block
+#endif
+
 ; *****************************************************************************
 
 
@@ -470,6 +579,323 @@ _UpdateChksum:
 ; *****************************************************************************
 
 
+; *****************************************************************************
+; Function: 	_bootCrc _Crc32Byte(WREG _bootCrc0)
+;
+; PreCondition:	_bootCrc0 - _bootCrc3 preset.
+;
+; Input:    	WREG
+;                               
+; Output:   	_bootCrc0 - _bootCrc3, not inverted.
+;
+; Side 
+; Effects: 		WREG, WREG1 and STATUS are corrupted.
+;
+; Stack 
+; Requirements: 1 level.
+;
+; Overview: 	This function shifts the byte in WREG into the reflected 
+;				CRC32 (polynomial 0xEDB88320).
+; *****************************************************************************
+_Crc32Byte:
+
+    xorwf	_bootCrc0, F			; Shift in the byte
+    movlw	0x08
+    movwf	WREG1
+
+_Crc32ByteLp1:
+
+    bcf		STATUS, C
+    rrcf	_bootCrc3, F
+    rrcf	_bootCrc2, F
+    rrcf	_bootCrc1, F
+    rrcf	_bootCrc0, F
+    bnc		_Crc32ByteJp1
+    movlw	0x20					; Add the polynomial
+    xorwf	_bootCrc0, F
+    movlw	0x83
+    xorwf	_bootCrc1, F
+    movlw	0xB8
+    xorwf	_bootCrc2, F
+    movlw	0xED
+    xorwf	_bootCrc3, F
+
+_Crc32ByteJp1:
+
+    decfsz	WREG1, F
+    bra		_Crc32ByteLp1
+    return
+; *****************************************************************************
+
+
+#ifdef	AB_SLOTS
+; *****************************************************************************
+; Function: 	VOID _SlotCopy(_abSrc, _abDst)
+;
+; PreCondition:	MODE_WRT_UNLCK set.
+;
+; Input:    	_abSrcL/H and _abDstL/H point to the start of a slot.
+;                               
+; Output:   	The destination slot holds a copy of the source slot.
+;
+; Side 
+; Effects: 		TBLPTR, FSR0, WREG1, WREG2 and EECON1 are corrupted.
+;
+; Stack 
+; Requirements: 2 levels.
+;
+; Overview: 	This function copies one slot in write blocks of 8 bytes,
+;				erasing each row of the destination on the way. Blocks
+;				that are all 0xFF are left erased.
+; *****************************************************************************
+_SlotCopy:
+
+    movlw	low ((AB_DESC - AB_SLOT_B) / 8)
+    movwf	_abCountL				; Count the blocks
+    movlw	high ((AB_DESC - AB_SLOT_B) / 8)
+    movwf	_abCountH
+    clrf	TBLPTRU
+
+_SlotCopyLp1:
+
+    clrwdt
+    movff	_abSrcL, TBLPTRL		; Read a block
+    movff	_abSrcH, TBLPTRH
+    lfsr	0, _abBuf
+    movlw	0x08
+    movwf	WREG1
+    setf	WREG2
+
+_SlotCopyLp2:
+
+    tblrd	*+
+    movf	TABLAT, W
+    movwf	POSTINC0
+    andwf	WREG2, F
+    decfsz	WREG1, F
+    bra		_SlotCopyLp2
+
+    movff	TBLPTRL, _abSrcL
+    movff	TBLPTRH, _abSrcH
+
+    movff	_abDstL, TBLPTRL
+    movff	_abDstH, TBLPTRH
+    movf	TBLPTRL, W				; Erase on a 64 byte border
+    andlw	b'00111111'
+    bnz		_SlotCopyJp1
+    movlw	b'10010100'
+    rcall	_StartWrite
+
+_SlotCopyJp1:
+
+    incf	WREG2, W				; Nothing to write if all 0xFF
+    btfss	STATUS, Z
+    rcall	_SlotWrite
+
+    movlw	0x08					; Next block
+    addwf	_abDstL, F
+    movlw	0x00
+    addwfc	_abDstH, F
+
+    decf	_abCountL, F			; Count down
+    btfss	STATUS, C
+    decf	_abCountH, F
+    movf	_abCountL, W
+    iorwf	_abCountH, W
+    bnz		_SlotCopyLp1
+    return
+
+
+; Write the block in _abBuf to TBLPTR, all 8 holding registers are loaded so
+; no stale byte of an earlier table write ends up in the row.
+_SlotWrite:
+
+    lfsr	0, _abBuf
+    movlw	0x08
+    movwf	WREG1
+
+_SlotWriteLp1:
+
+    movff	POSTINC0, TABLAT		; Load the holding registers
+    tblwt	*+
+    decfsz	WREG1, F
+    bra		_SlotWriteLp1
+
+    tblrd	*-						; Point back into the block
+    movlw	b'10000100'				; Setup writes
+    bra		_StartWrite				; Write the data
+; *****************************************************************************
+
+
+; *****************************************************************************
+; Function: 	_bootCrc _SlotCrc()
+;
+; PreCondition:	Nothing
+;
+; Input:    	None.
+;                               
+; Output:   	_bootCrc0 - _bootCrc3, the CRC32 of slot B, not inverted.
+;				TBLPTR points to the descriptor (AB_DESC).
+;
+; Side 
+; Effects: 		WREG, WREG1 and STATUS are corrupted.
+;
+; Stack 
+; Requirements: 2 levels.
+; *****************************************************************************
+_SlotCrc:
+
+    setf	_bootCrc0				; Preset the CRC
+    setf	_bootCrc1
+    setf	_bootCrc2
+    setf	_bootCrc3
+
+    movlw	low (AB_DESC - AB_SLOT_B)
+    movwf	_abCountL
+    movlw	high (AB_DESC - AB_SLOT_B)
+    movwf	_abCountH
+
+    clrf	TBLPTRU
+    movlw	high AB_SLOT_B
+    movwf	TBLPTRH
+    movlw	low AB_SLOT_B
+    movwf	TBLPTRL
+
+_SlotCrcLp1:
+
+    clrwdt
+    tblrd	*+
+    movf	TABLAT, W
+    rcall	_Crc32Byte
+
+    decf	_abCountL, F			; Count down
+    btfss	STATUS, C
+    decf	_abCountH, F
+    movf	_abCountL, W
+    iorwf	_abCountH, W
+    bnz		_SlotCrcLp1
+    return
+; *****************************************************************************
+
+
+; *****************************************************************************
+; Function: 	VOID _SlotBackup()
+;
+; PreCondition:	Slot A passed CMD_CHK_RUN, MODE_WRT_UNLCK set.
+;
+; Input:    	None.
+;                               
+; Output:   	Slot B holds a sealed copy of slot A.
+;
+; Side 
+; Effects: 		TBLPTR, FSR0, WREG1, WREG2 and EECON1 are corrupted.
+;
+; Stack 
+; Requirements: 3 levels.
+;
+; Overview: 	The descriptor is erased first, so slot B is never sealed
+;				while it is only partly copied.
+; *****************************************************************************
+_SlotBackup:
+
+    clrf	TBLPTRU					; Drop the old rollback image
+    movlw	high AB_DESC
+    movwf	TBLPTRH
+    movlw	low AB_DESC
+    movwf	TBLPTRL
+    movlw	b'10010100'				; Setup erase
+    rcall	_StartWrite
+
+    movlw	low RESET_VECT			; Copy slot A to slot B
+    movwf	_abSrcL
+    movlw	high RESET_VECT
+    movwf	_abSrcH
+    movlw	low AB_SLOT_B
+    movwf	_abDstL
+    movlw	high AB_SLOT_B
+    movwf	_abDstH
+    rcall	_SlotCopy
+
+    rcall	_SlotCrc				; Seal it, TBLPTR is left on the
+    movff	_bootCrc0, _abBuf		; descriptor
+    movff	_bootCrc1, _abBuf + 1
+    movff	_bootCrc2, _abBuf + 2
+    movff	_bootCrc3, _abBuf + 3
+    clrf	_abBuf + 4				; Sealed, the rest stays erased
+    setf	_abBuf + 5
+    setf	_abBuf + 6
+    setf	_abBuf + 7
+    bra		_SlotWrite
+; *****************************************************************************
+
+
+; *****************************************************************************
+; Function: 	VOID _Rollback()
+;
+; PreCondition:	Enter only from _CANMainLp after AB_TIMEOUT of silence.
+;
+; Input:    	None.
+;                               
+; Output:   	None. 
+;
+; Side 
+; Effects: 		N/A. 
+;
+; Stack 
+; Requirements: N/A
+;
+; Overview: 	If slot B is sealed and matches its CRC it is copied to
+;				slot A, the boot flag is cleared and the node is reset into
+;				the application. Otherwise the bootloader keeps waiting.
+; *****************************************************************************
+_Rollback:
+
+    rcall	_SlotCrc				; Check slot B against the descriptor
+    lfsr	0, _bootCrc0
+    movlw	0x04
+    movwf	WREG1
+
+_RollbackLp1:
+
+    tblrd	*+
+    movf	TABLAT, W
+    xorwf	POSTINC0, W
+    bnz		_RollbackJp1
+    decfsz	WREG1, F
+    bra		_RollbackLp1
+
+    tblrd	*+						; and that it is sealed
+    movf	TABLAT, W
+    bnz		_RollbackJp1
+
+    bsf		MODE_WRT_UNLCK
+    movlw	low AB_SLOT_B			; Copy slot B to slot A
+    movwf	_abSrcL
+    movlw	high AB_SLOT_B
+    movwf	_abSrcH
+    movlw	low RESET_VECT
+    movwf	_abDstL
+    movlw	high RESET_VECT
+    movwf	_abDstH
+    rcall	_SlotCopy
+
+    banksel EEADR					; Clear the boot flag
+#ifdef __18F26K80
+    clrf	EEADRH
+#endif
+    clrf	EEADR
+    clrf	EEDATA
+    movlw	b'00000100'				; Setup for EEData
+    rcall	_StartWrite
+    reset							; and run the application
+
+_RollbackJp1:
+
+    bra		_CANMainLp				; No rollback image, keep waiting
+; *****************************************************************************
+#endif
+
+
 ; *****************************************************************************
 ; Function: 	 VOID _CANInit(CAN, BOOT)
 ;
@@ -569,6 +995,17 @@ bootload_mode:
     movlw	b'00000100'				; Setup for EEData
     rcall   _StartWrite    
     clrf	_bootSpcCmd				; Reset the special command register
+    clrf	_bootWin				; Start with RXB0
+    clrf	_bootErrStat
+#ifdef	ALLOW_PACK
+    bsf		CAP_PACK
+#endif
+#ifdef	AB_SLOTS
+    movlw	b'10000111'				; TMR0 16 bit 1:256 counts the silence
+    movwf	T0CON
+    movlw	AB_TIMEOUT
+    movwf	_abIdle
+#endif
 
 	; Get Nickname from EEPROM and save in RAM
     banksel EECON1
@@ -611,6 +1048,38 @@ bootload_mode:
     movwf	RXM0EIDH
     movlw	CAN_RXM0EIDL
     movwf	RXM0EIDL
+
+    ; RXB1 takes the same messages, it holds the next message while the 
+    ; current one is being written (see _CANMain)
+    movlw	CAN_RXF0SIDH			; Set filters 2-5
+    movwf	RXF2SIDH
+    movwf	RXF3SIDH
+    movwf	RXF4SIDH
+    movwf	RXF5SIDH
+    movlw	CAN_RXF0SIDL
+    movwf	RXF2SIDL
+    movwf	RXF3SIDL
+    movwf	RXF4SIDL
+    movwf	RXF5SIDL
+    movlw	CAN_RXF0EIDH
+    movwf	RXF2EIDH
+    movwf	RXF3EIDH
+    movwf	RXF4EIDH
+    movwf	RXF5EIDH
+    movlw	CAN_RXF0EIDL
+    movwf	RXF2EIDL
+    movwf	RXF3EIDL
+    movwf	RXF4EIDL
+    movwf	RXF5EIDL
+
+    movlw	CAN_RXM0SIDH			; Set mask 1
+    movwf	RXM1SIDH
+    movlw	CAN_RXM0SIDL
+    movwf	RXM1SIDL
+    movlw	CAN_RXM0EIDH
+    movwf	RXM1EIDH
+    movlw	CAN_RXM0EIDL
+    movwf	RXM1EIDL
 	
     movlw	CAN_BRGCON1				; Set bit rate
     movwf	BRGCON1
@@ -624,6 +1093,7 @@ bootload_mode:
     movwf	CIOCON
 		
     clrf	CANCON					; Enter Normal mode
+    bsf		RXB0CON, RXB0DBEN		; Roll over to RXB1 while RXB0 is full
 
     goto 	_CANSendAck2			; AKHE Initial message from boot loader
 	
@@ -648,10 +1118,43 @@ _CANMain:
     banksel RXB0CON
     bcf		RXB0CON, RXFUL		; Clear the receive flag
 
-    ; Wait for CAN messsage
+    ; Wait for CAN messsage. Both receive buffers are mapped in turn on the
+    ; RXB0 registers. A message only goes to RXB1 while RXB0 is full, so
+    ; the other buffer holds the oldest message when both are full.
+_CANMainLp:
     clrwdt						; AKHE: Clear watchdog on every turn
+#ifdef	AB_SLOTS
+    btfss	INTCON, TMR0IF		; Count the silence on the bus
+    bra		_CANMainJp0
+    bcf		INTCON, TMR0IF
+    movf	_abIdle, F			; Not armed
+    bz		_CANMainJp0
+    decfsz	_abIdle, F
+    bra		_CANMainJp0
+    bra		_Rollback
+
+_CANMainJp0:
+#endif
+    movlw	CAN_WIN_RXB0 ^ CAN_WIN_RXB1
+    xorwf	_bootWin, F			; Try the other buffer first
+    movff	_bootWin, CANCON
+    btfsc	RXB0CON, RXFUL
+    bra		_CANMainRx
+    xorwf	_bootWin, F			; Then the last one again
+    movff	_bootWin, CANCON
     btfss	RXB0CON, RXFUL		; Wait for a message
-    bra		$ - 4				; AKHE: 
+    bra		_CANMainLp
+
+_CANMainRx:
+
+#ifdef	AB_SLOTS
+    movlw	AB_TIMEOUT			; Restart the silence count
+    movwf	_abIdle
+    movf	RXB0EIDH, W			; Any protocol frame counts as activity,
+    andlw	0xFC				; only types 16-19 are for the bootloader
+    xorlw	0x10
+    bnz		_CANMain
+#endif
 	
     banksel PORTC
     bsf     PORTC,RC1           ; AKHE: status off
@@ -738,6 +1241,24 @@ _ReadWriteMemory:
 ; Then is executes any immediate command received.
 
 _ControlReg:
+
+#ifdef 	ALLOW_GET_CMD
+    movf	RXB0EIDL, W				; For all nodes or only for this one?
+    bz		_ControlRegJp1
+    xorwf	_vscpNickname, W
+    btfss	STATUS, Z
+    bra		_CANMain
+
+_ControlRegJp1:
+
+    btfss	CAN_PG_BIT				; Report the status on a get
+    bra		_ControlRegJp2
+    movff	_bootErrStat, _unused0
+    movff	_bootChksmL, _bootChkL
+    movff	_bootChksmH, _bootChkH
+
+_ControlRegJp2:
+#endif
     
     lfsr	1, _bootCtlMem
 	
@@ -758,6 +1279,30 @@ _ControlRegLp1:
 #ifdef 	ALLOW_GET_CMD
     btfsc	CAN_PG_BIT	
     bra		_CANSendResponce		; Send response if get
+
+    bcf		ERR_SEQ					; New pointer, restart the sequence
+#endif
+; *********************************************************	
+
+; *********************************************************	
+; This is the start of a packed stream. The decoder is reset
+; and writes from the pointer. As with the NOP command an 
+; acknowledge is always sent.
+
+#ifdef	ALLOW_PACK
+    movf	_bootSpcCmd, W			; PACK Command
+    xorlw	CMD_PACK
+    bnz		_ControlRegJp3
+
+    movff	_bootAddrL, _packAddrL
+    movff	_bootAddrH, _packAddrH
+    movff	_bootAddrU, _packAddrU
+    clrf	_packCnt
+    clrf	_packFlags
+    clrf	_packFill
+    goto	_CANSendAck2
+
+_ControlRegJp3:
 #endif
 ; *********************************************************
 
@@ -789,6 +1334,7 @@ _ControlRegLp1:
     clrf	_bootChksmH				; Reset chksum
     clrf	_bootChksmL
     bcf		ERR_VERIFY				; Clear the error verify flag
+    bcf		ERR_ALIGN
 	
 ; *********************************************************	
 
@@ -822,14 +1368,96 @@ _SpecialCmdJp1:
     clrf	EEDATA					; and clear the data
     movlw	b'00000100'				; Setup for EEData
     rcall	_StartWrite
+#ifdef	AB_SLOTS
+    rcall	_SlotBackup				; Keep the image for a rollback
+#endif
 	
 _SpecialCmdJp2:
 
 #ifdef 	ALLOW_GET_CMD
+    movf	_bootSpcCmd, W			; CRC32 Command
+    xorlw	CMD_CRC32
+    bz		_CRC32
+
     bra		_CANSendAck				; or send an acknowledge
 #else
     goto	_CANMain
 #endif					
+; *********************************************************	
+
+; *********************************************************	
+; This is the CRC32 command. The CRC (reflected, polynomial
+; 0xEDB88320) is taken over the program memory or EEDATA from
+; the pointer on, the special data is the count. 
+
+#ifdef 	ALLOW_GET_CMD
+_CRC32:
+
+    setf	_bootCrc0				; Preset the CRC
+    setf	_bootCrc1
+    setf	_bootCrc2
+    setf	_bootCrc3
+
+    banksel TBLPTRU
+    movff	_bootAddrU, TBLPTRU		; Copy the pointer
+    movff	_bootAddrH, TBLPTRH
+    movff	_bootAddrL, TBLPTRL
+    banksel EEADR
+    movff	_bootAddrH, EEADRH
+    movff	_bootAddrL, EEADR
+
+_CRC32Lp1:
+
+    clrwdt
+    movf	_bootChkL, W			; Done if the count is zero
+    iorwf	_bootChkH, W
+    bz		_CRC32Jp3
+
+    movf	_bootAddrU, W			; EEPROM data = 0xF00000
+    xorlw	0xF0
+    bz		_CRC32Jp1
+
+    banksel TABLAT
+    tblrd	*+						; Read program memory
+    movf	TABLAT, W
+    bra		_CRC32Jp2
+
+_CRC32Jp1:
+
+    banksel EECON1
+    clrf	EECON1 
+    bsf		EECON1, RD				; Read EEDATA
+    movf	EEDATA, W
+    infsnz	EEADR, F
+    incf	EEADRH, F
+
+_CRC32Jp2:
+
+    rcall	_Crc32Byte				; Shift in the byte
+
+    decf	_bootChkL, F			; Count down
+    btfss	STATUS, C
+    decf	_bootChkH, F
+    bra		_CRC32Lp1
+
+_CRC32Jp3:
+
+    banksel TXB0CON
+    btfsc	TXB0CON,TXREQ			; Wait for the buffer to empty
+    bra		$ - 2
+
+    comf	_bootCrc0, W			; Invert and send the CRC
+    movwf	TXB0D0
+    comf	_bootCrc1, W
+    movwf	TXB0D1
+    comf	_bootCrc2, W
+    movwf	TXB0D2
+    comf	_bootCrc3, W
+    movwf	TXB0D3
+    movlw	0x04
+    movwf	TXB0DLC
+    bra		_CANSendMessage
+#endif
 ; *****************************************************************************
 	
 
@@ -844,6 +1472,52 @@ _SpecialCmdJp2:
 
 _DataReg:
 
+#ifdef 	ALLOW_GET_CMD
+    btfsc	CAN_PG_BIT				; Only puts are sequence checked
+    bra		_SetPointers
+    btfsc	MODE_MUTE				; Not taking part in the stream
+    bra		_CANMain
+    btfss	MODE_SEQ
+    bra		_DataRegJp1
+    btfsc	ERR_SEQ					; Lost a put before, drop the rest
+    bra		_CANMain
+    movf	RXB0EIDL, W				; Drop a put out of sequence and
+    xorwf	_bootAddrL, W			; report the pointer
+    btfsc	STATUS, Z
+    bra		_DataRegJp1
+    btfss	MODE_ACK				; Without acknowledge the source can't
+    bsf		ERR_SEQ					; resync
+    bra		_CANSendAck
+#endif
+
+_DataRegJp1:
+
+#ifdef	ALLOW_PACK
+    btfsc	MODE_PACK				; Decode a packed put
+    bra		_Unpack
+#endif
+
+    btfsc	MODE_ERASE_ONLY			; A put to program memory must be one
+    bra		_SetPointers			; whole write block
+    movlw	0x30
+    cpfslt	_bootAddrU
+    bra		_SetPointers
+    movf	_bootAddrL, W
+    andlw	b'00000111'
+    bnz		_DataRegJp2
+    movlw	0x08
+    xorwf	_bootCount, W
+    bz		_SetPointers
+
+_DataRegJp2:
+
+    bsf		ERR_ALIGN				; Not written, acknowledge the unchanged
+#ifdef 	ALLOW_GET_CMD				; pointer
+    bra		_CANSendAck
+#else
+    goto	_CANMain
+#endif
+
 ; *********************************************************	
 							
 _SetPointers:
@@ -924,6 +1598,7 @@ _DecodeJp3:
 ; *****************************************************************************
 ; Function: 	VOID _PMRead()
 ;				VOID _PMEraseWrite()
+;				VOID _PMBlock()
 ;
 ; PreCondition:	WREG1 and FSR0 must be loaded with the count and address of
 ;				the source data.
@@ -941,7 +1616,8 @@ _DecodeJp3:
 ; Overview: 	These routines are technically not functions since they will not 
 ;				return when called. They have been written in a linear form to 
 ;				save space.	Thus 'call' and 'return' instructions are not 
-;				included, but rather they are implied.	
+;				included, but rather they are implied. _PMBlock is a function
+;				that erases and writes one block, for plain and packed puts.
 ;
 ; 				These are the program memory read/write functions. Erase is
 ; 				available through control flags. An automatic erase option
@@ -967,6 +1643,15 @@ _PMRead:
 ; *********************************************************
 _PMEraseWrite:
 
+    rcall	_PMBlock
+#ifdef 	ALLOW_GET_CMD
+    bra		_CANSendAck
+#else
+    goto	_CANMain
+#endif
+
+_PMBlock:
+
     btfss	MODE_AUTO_ERASE			; Erase if auto erase is requested
     bra		_PMWrite
 
@@ -985,18 +1670,13 @@ _PMEraseJp1:
 _PMWrite:
 
     btfsc	MODE_ERASE_ONLY			; Don't write if erase only is requested
-#ifdef 	ALLOW_GET_CMD
-    bra		_CANSendAck
-#else
-    goto	_CANMain
-#endif
+    return
 
     banksel TBLPTRL
     movf	TBLPTRL, W				; Check for a valid 8 byte border
     andlw	b'00000111'
-    ;bnz		_CANMain	
-    bz      _PMWriteLp0
-    goto    _CANMain
+    btfss	STATUS, Z
+    return
 
 _PMWriteLp0:    
     movlw	0x08
@@ -1053,12 +1733,7 @@ _PMReadBackLp1:
 
     tblrd	*+						; Return the pointer position	
 #endif
-
-#ifdef 	ALLOW_GET_CMD
-    bra		_CANSendAck
-#else
-    goto	_CANMain
-#endif
+    return
 ; *****************************************************************************
 
 
@@ -1132,6 +1807,7 @@ _CFGWrite:
 ; *****************************************************************************
 ; Function: 	VOID _EERead()
 ;				VOID _EEWrite()
+;				VOID _EEBlock()
 ;
 ; PreCondition:	WREG1 and FSR0 must be loaded with the count and address of
 ;		the source data.
@@ -1149,7 +1825,8 @@ _CFGWrite:
 ; Overview: 	These routines are technically not functions since they will not 
 ;		return when called. They have been written in a linear form to 
 ;		save space.	Thus 'call' and 'return' instructions are not 
-;		included, but rather they are implied.	
+;		included, but rather they are implied. _EEBlock is a function
+;		that writes WREG1 bytes, for plain and packed puts.
 ;
 ;		This is the EEDATA memory read/write functions.
 ; *****************************************************************************
@@ -1177,6 +1854,15 @@ _EERead:
 
 _EEWrite:
 
+    rcall	_EEBlock
+#ifdef 	ALLOW_GET_CMD
+    bra		_CANSendAck
+#else
+    goto	_CANMain
+#endif
+
+_EEBlock:
+
     banksel INDF0
 #ifdef MODE_SELF_VERIFY
     movf	INDF0, W                ; Load data
@@ -1203,12 +1889,202 @@ _EEWrite:
     incf	EEADRH, F
 
     decfsz	WREG1, F		
-    bra		_EEWrite                ; Not finished then repeat
+    bra		_EEBlock                ; Not finished then repeat
+    return
+; *****************************************************************************
+
+
+
+
+; *****************************************************************************
+; Function: 	VOID _Unpack()
+;				VOID _PackOut(WREG)
+;
+; PreCondition:	_Unpack: enter only after _DataReg() with MODE_PACK.
+;				_PackOut: the stream was started with CMD_PACK.
+;
+; Input:    	The packed data in the receive buffer.
+;                               
+; Output:   	None. 
+;
+; Side 
+; Effects: 		N/A. 
+;
+; Stack 
+; Requirements: 2 levels.
+;
+; Overview: 	_Unpack is technically not a function, it has been written
+;				in a linear form as the other memory routines.
+;
+;				The received bytes are decoded (see CMD_PACK) and each
+;				decoded byte is passed to _PackOut, which collects a write
+;				block and writes it to program memory or EEDATA at the 
+;				write pointer. The control pointer counts the received 
+;				bytes, so the sequence check and the acknowledge work on 
+;				the position in the stream.
+;
+;				The flash that is already written is the history of the
+;				stream: a copy reads its source back with TBLRD, so the
+;				decoder needs no RAM for a window. The decoder state is
+;				kept between puts, a control byte and its operands may
+;				be split over two puts.
+; *****************************************************************************
+#ifdef	ALLOW_PACK
+
+_Unpack:
+
+    movf	_bootCount, W			; Advance the stream position
+    addwf	_bootAddrL, F
+    movlw	0x00
+    addwfc	_bootAddrH, F
+    addwfc	_bootAddrU, F
+
+    lfsr	2, RXB0D0				; FSR2 walks RX, _PackOut and _PMBlock use FSR0/1
+
+_UnpackLp1:
+
+    movf	POSTINC2, W
+    btfsc	PACK_ARG				; The operand of a run or a copy?
+    bra		_UnpackJp2
+    tstfsz	_packCnt				; In a literal?
+    bra		_UnpackJp1
+
+    clrf	_packFlags				; A control byte
+    btfsc	WREG, 7
+    bra		_UnpackJp0
+    addlw	0x01					; c+1 literal bytes
+    movwf	_packCnt
+    bra		_UnpackJp5
+
+_UnpackJp0:
+
+    bsf		PACK_ARG				; A run or a copy of 3-66 bytes
+    btfsc	WREG, 6
+    bsf		PACK_COPY
+    andlw	0x3F
+    addlw	0x03
+    movwf	_packCnt
+    bra		_UnpackJp5
+
+_UnpackJp1:
+
+    rcall	_PackOut				; A literal byte
+    decf	_packCnt, F
+    bra		_UnpackJp5
+
+_UnpackJp2:
+
+    btfsc	PACK_COPY
+    bra		_UnpackJp3
+
+    movwf	_packVal				; The byte of a run
+    bcf		PACK_ARG
+
+_UnpackLp2:
+
+    movf	_packVal, W
+    rcall	_PackOut
+    decfsz	_packCnt, F
+    bra		_UnpackLp2
+    bra		_UnpackJp5
+
+_UnpackJp3:
+
+    btfsc	PACK_DIST
+    bra		_UnpackJp4
+    movwf	_packVal				; Low byte of the distance
+    bsf		PACK_DIST
+    bra		_UnpackJp5
+
+_UnpackJp4:
+
+    movwf	WREG2					; The source is the write position
+    movf	_packFill, W			; minus the distance
+    iorwf	_packAddrL, W
+    movwf	_packSrcL
+    movf	_packVal, W
+    subwf	_packSrcL, F
+    movff	_packAddrH, _packSrcH
+    movf	WREG2, W
+    subwfb	_packSrcH, F
+    movff	_packAddrU, _packSrcU
+    movlw	0x00
+    subwfb	_packSrcU, F
+    bcf		PACK_ARG
+
+_UnpackLp3:
+
+    movff	_packSrcU, TBLPTRU		; Copy from the program memory that
+    movff	_packSrcH, TBLPTRH		; is already written
+    movff	_packSrcL, TBLPTRL
+    tblrd	*+
+    movff	TBLPTRL, _packSrcL
+    movff	TBLPTRH, _packSrcH
+    movff	TBLPTRU, _packSrcU
+    movf	TABLAT, W
+    rcall	_PackOut
+    decfsz	_packCnt, F
+    bra		_UnpackLp3
+
+_UnpackJp5:
+
+    decfsz	_bootCount, F
+    bra		_UnpackLp1
 
 #ifdef 	ALLOW_GET_CMD
+    bra		_CANSendAck
 #else
     goto	_CANMain
 #endif
+; *********************************************************
+
+; *********************************************************
+_PackOut:
+
+    clrwdt
+    movwf	WREG2					; Add the byte to the block
+    lfsr	1, _packBuf
+    movf	_packFill, W
+    movff	WREG2, PLUSW1
+    incf	_packFill, F
+    btfss	_packFill, 3			; Until it holds 8 bytes
+    return
+    clrf	_packFill
+
+    banksel TBLPTRU
+    movff	_packAddrU, TBLPTRU		; Point at the block
+    movff	_packAddrH, TBLPTRH
+    movff	_packAddrL, TBLPTRL
+    banksel EECON1
+    movff	_packAddrH, EEADRH
+    movff	_packAddrL, EEADR
+
+    movlw	0x08					; Move the write pointer
+    addwf	_packAddrL, F
+    movlw	0x00
+    addwfc	_packAddrH, F
+    addwfc	_packAddrU, F
+
+    lfsr	0, _packBuf
+    movlw	0x08
+    movwf	WREG1
+
+    movf	TBLPTRU, W				; Program memory < 0x300000
+    andlw	0xF0
+    movwf	WREG2
+    movlw	0x30
+    cpfslt	WREG2
+    bra		_PackOutJp1
+    bra		_PMBlock
+
+_PackOutJp1:
+
+    movf	WREG2, W				; EEPROM data = 0xF00000
+    xorlw	0xF0
+    btfsc	STATUS, Z
+    bra		_EEBlock
+    return							; Config memory isn't packed
+#endif
 ; *****************************************************************************
 
 
@@ -1237,7 +2113,7 @@ _EEWrite:
 ;		included, but rather they are implied.	
 ;
 ; 		These routines are used for 'talking back' to the source. The 
-;		_CANSendAck routine sends an empty message to indicate 
+;		_CANSendAck routine sends the memory pointer to indicate 
 ;		acknowledgement of a memory write operation. The 
 ;		_CANSendResponce is used to send data back to the source.
 ; *****************************************************************************
@@ -1251,7 +2127,14 @@ _CANSendAck:
 _CANSendAck2:		
 
     banksel TXB0DLC
-    clrf	TXB0DLC                     ; Setup for a 0 byte transmission
+    btfsc	TXB0CON,TXREQ				; Wait for the buffer to empty
+    bra		$ - 2
+
+    movff	_bootAddrL, TXB0D0			; Report the pointer
+    movff	_bootAddrH, TXB0D1
+    movff	_bootAddrU, TXB0D2
+    movlw	0x03                        ; Setup for a 3 byte transmission
+    movwf	TXB0DLC
     bra		_CANSendMessage
 #endif
 ; *********************************************************
@@ -18,14 +18,32 @@
 #include "can.h"
 #include "ecan.h"
 
+/* The controller leaves bus-off on its own after 128 x 11 recessive bits.
+ * It is not restarted from here: that would clear the error counters and
+ * let a faulty node back on the bus, defeating the fault confinement.
+ */
+
+static can_stats_t stats;
+static uint8_t error_state;
+
+static uint8_t tx_buffers_free(void);
+
 void can_init(void)
 {
     ECANInitialize();
 }
 
-uint8_t can_send_extended(can_id_t id, uint8_t data[], uint8_t data_len)
+uint8_t can_send_extended(can_id_t id, uint8_t data[], uint8_t data_len, uint8_t priority)
 {
-    return ECANSendMessage(id, data, data_len, ECAN_TX_XTD_FRAME);
+    if (!(priority & CAN_TX_URGENT) && (tx_buffers_free() < 2))
+        return 0;
+
+    if (!ECANSendMessage(id, data, data_len, (ECAN_TX_MSG_FLAGS)
+                         (ECAN_TX_XTD_FRAME | (priority & ECAN_TX_PRIORITY_BITS))))
+        return 0;
+
+    stats.tx_frames++;
+    return 1;
 }
 
 uint8_t can_receive_extended(can_id_t *id, uint8_t data[], uint8_t *data_len)
@@ -34,6 +52,13 @@ uint8_t can_receive_extended(can_id_t *id, uint8_t data[], uint8_t *data_len)
     uint8_t rv;
 
     rv = ECANReceiveMessage(id, data, data_len, &flags);
+    if (rv)
+        stats.rx_frames++;
+    if ((flags & ECAN_RX_OVERFLOW) && (stats.rx_overflows < 0xFF))
+    {
+        stats.rx_overflows++;
+    }
+
     // RTR not interesting
     if (flags & ECAN_RX_RTR_FRAME)
     {
@@ -48,6 +73,93 @@ uint8_t can_receive_extended(can_id_t *id, uint8_t data[], uint8_t *data_len)
     return rv;
 }
 
+// TXB0..2 and the programmable buffers which are set up for transmit, the
+// same buffers ECANSendMessage() looks for an empty one in
+static uint8_t tx_buffers_free(void)
+{
+    uint8_t count = 0;
+    uint8_t bsel = BSEL0 >> 2;
+
+    if (!(TXB0CON & 0x08))
+        count++;
+    if (!(TXB1CON & 0x08))
+        count++;
+    if (!(TXB2CON & 0x08))
+        count++;
+    if ((bsel & 0x01) && !(B0CON & 0x08))
+        count++;
+    if ((bsel & 0x02) && !(B1CON & 0x08))
+        count++;
+    if ((bsel & 0x04) && !(B2CON & 0x08))
+        count++;
+    if ((bsel & 0x08) && !(B3CON & 0x08))
+        count++;
+    if ((bsel & 0x10) && !(B4CON & 0x08))
+        count++;
+    if ((bsel & 0x20) && !(B5CON & 0x08))
+        count++;
+    return count;
+}
+
+void can_process(void)
+{
+    uint8_t state;
+
+    if (COMSTATbits.TXBO)
+        state = CAN_BUS_OFF;
+    else if (COMSTATbits.TXBP || COMSTATbits.RXBP)
+        state = CAN_ERROR_PASSIVE;
+    else
+        state = CAN_ERROR_ACTIVE;
+
+    if (state != error_state)
+    {
+        if ((state == CAN_ERROR_PASSIVE) && (stats.error_passive < 0xFF))
+            stats.error_passive++;
+        if (state == CAN_BUS_OFF)
+        {
+            if (stats.bus_off < 0xFF)
+                stats.bus_off++;
+            // whatever is pending would go out in a burst on recovery
+            CANCONbits.ABAT = 1;
+        }
+        else if (error_state == CAN_BUS_OFF)
+        {
+            CANCONbits.ABAT = 0;
+        }
+        error_state = state;
+    }
+}
+
+uint8_t can_error_state(void)
+{
+    return error_state;
+}
+
+uint8_t can_tx_error_count(void)
+{
+    return TXERRCNT;
+}
+
+uint8_t can_rx_error_count(void)
+{
+    return RXERRCNT;
+}
+
+const can_stats_t * can_get_stats(void)
+{
+    return &stats;
+}
+
+void can_clear_stats(void)
+{
+    stats.rx_frames = 0;
+    stats.tx_frames = 0;
+    stats.rx_overflows = 0;
+    stats.error_passive = 0;
+    stats.bus_off = 0;
+}
+
 void can_add_rx_filter(can_id_t mask, can_id_t filter)
 {
     static uint32_t the_mask = 0xffffffff;
@@ -15,12 +15,44 @@ extern "C" {
 
     typedef uint32_t can_id_t;
 
+    // error state of the controller, see can_process()
+#define CAN_ERROR_ACTIVE  0
+#define CAN_ERROR_PASSIVE 1
+#define CAN_BUS_OFF       2
+
+    typedef struct
+    {
+        uint32_t rx_frames;
+        uint32_t tx_frames;
+        uint8_t rx_overflows;  // received frames lost, saturates at 255
+        uint8_t error_passive; // times error-passive was entered, saturates
+        uint8_t bus_off;       // times bus-off was entered, saturates
+    } can_stats_t;
+
     void can_init(void);
 
-    uint8_t can_send_extended(can_id_t id, uint8_t data[], uint8_t data_len);
+    // transmit priority: the controller sends pending frames with the
+    // highest priority first. One TX buffer is kept free for urgent frames.
+#define CAN_TX_PRIORITY_LOW     0x00
+#define CAN_TX_PRIORITY_MEDIUM  0x01
+#define CAN_TX_PRIORITY_HIGH    0x02
+#define CAN_TX_PRIORITY_HIGHEST 0x03
+#define CAN_TX_URGENT           0x80
+
+    uint8_t can_send_extended(can_id_t id, uint8_t data[], uint8_t data_len, uint8_t priority);
 
     uint8_t can_receive_extended(can_id_t *id, uint8_t data[], uint8_t *data_len);
 
+    // call periodically, keeps track of the error state of the controller
+    // and recovers from bus-off
+    void can_process(void);
+    uint8_t can_error_state(void);
+    uint8_t can_tx_error_count(void);
+    uint8_t can_rx_error_count(void);
+
+    const can_stats_t * can_get_stats(void);
+    void can_clear_stats(void);
+
     void can_add_rx_filter(can_id_t mask, can_id_t filter);
 
 
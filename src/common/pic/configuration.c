@@ -24,6 +24,7 @@
 static uint8_t data_size;
 static char * user_data;
 static uint8_t equal_count = 0;
+static unsigned int write_count = 0;
 
 void config_update (void);
 void eeprom_write_local( unsigned int badd,unsigned char bdat );
@@ -56,6 +57,11 @@ void config_wait_written (void)
     {};
 }
 
+unsigned int config_write_count (void)
+{
+    return write_count;
+}
+
 void config_update (void)
 {
     static uint8_t offset = 0;
@@ -69,6 +75,7 @@ void config_update (void)
         if(user_data[offset] != eeprom_read_local(offset))
         {
             eeprom_write_local(offset, user_data[offset]);
+            write_count++;
             return;
         }
         offset++;
@@ -82,14 +89,18 @@ void config_update (void)
 
 void eeprom_write_local( unsigned int badd,unsigned char bdat )
 {
+	uint8_t gie = INTCONbits.GIEH;  // a high priority interrupt
+	                                // would break the unlock sequence
 	while(EECON1bits.WR);	       //Wait till the previous write completion
 	EEADR = (badd & 0x0ff);
   	EEDATA = bdat;
   	EECON1bits.EEPGD = 0;
 	EECON1bits.CFGS = 0;
+	INTCONbits.GIEH = 0;
 	EECON2 = 0x55;
 	EECON2 = 0xAA;
 	EECON1bits.WR = 1;
+	INTCONbits.GIEH = gie;
 }
 
 unsigned char eeprom_read_local( unsigned int badd )
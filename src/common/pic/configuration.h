@@ -10,6 +10,8 @@
 
 extern void config_init (void * data, unsigned int size);
 extern void config_wait_written (void);
+// number of bytes written to EEPROM since power up
+extern unsigned int config_write_count (void);
 
 #endif	/* CONFIGURATION_H */
 
@@ -617,7 +617,7 @@ BOOL ECANSendMessage( unsigned long id,
 #elif ( ECAN_FUNC_MODE == ECAN_MODE_0 )
     #define buffers 2
 #else
-    #define buffers 8
+    #define buffers 9
 
 #endif
 
@@ -656,7 +656,7 @@ BOOL ECANSendMessage( unsigned long id,
     if ( mode == ECAN_MODE_0 )
         buffers = 2;
     else
-        buffers = 8;
+        buffers = 9;    // TXB0..2 and B0..B5
 #endif
 
 
@@ -806,6 +806,7 @@ BOOL ECANReceiveMessage(unsigned long *id,
     BYTE_VAL temp;
 
     _ECANRxFilterHitInfo.Val = 0;
+    *msgFlags = 0;
 
 #if ( ECAN_LIB_MODE_VAL == ECAN_LIB_MODE_RUN_TIME )
     mode = ECANCON&0xC0;
@@ -936,7 +937,6 @@ _SaveMode12Message:
 
 _SaveMessage:
     savedPtr = ptr;
-    *msgFlags = 0;
 
     // Retrieve message length.
     temp.Val = *(ptr+5);
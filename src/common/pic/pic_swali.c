@@ -63,6 +63,21 @@ void initialize_config_data(void)
     }
 }
 
+// CRC-8 (polynomial 0x07) of the swali configuration, lets monitoring spot
+// nodes which aren't configured as expected
+static uint8_t config_crc(void)
+{
+    uint8_t crc = 0;
+
+    for (uint16_t i = CONFIG_SWALI; i < config_data_size; i++)
+    {
+        crc ^= config_data[i];
+        for (uint8_t j = 0; j < 8; j++)
+            crc = (crc & 0x80) ? (uint8_t) ((crc << 1) ^ 0x07) : (uint8_t) (crc << 1);
+    }
+    return crc;
+}
+
 uint8_t process_button(void)
 {
     static uint16_t push_start;
@@ -125,6 +140,32 @@ void vscp_message_handler(vscp_message_t * message)
         }
         break;
 
+    case VSCP_SET | VSCP_MSG_PUBLISH_STATE:
+        swali_publish_state();
+        break;
+
+    case VSCP_GET | VSCP_MSG_HEARTBEAT:
+        message->value[1] = config_data[CONFIG_HEARTBEAT];
+        message->length = 2;
+        break;
+
+    case VSCP_SET | VSCP_MSG_HEARTBEAT:
+        config_data[CONFIG_HEARTBEAT] = message->value[1];
+        break;
+
+    case VSCP_GET | VSCP_MSG_EEPROM_WRITES:
+        if (message->value[0] < 2)
+        {
+            message->value[1] = (uint8_t) (config_write_count() >> (message->value[0] ? 0 : 8));
+            message->length = 2;
+        }
+        break;
+
+    case VSCP_GET | VSCP_MSG_CONFIG_CRC:
+        message->value[1] = config_crc();
+        message->length = 2;
+        break;
+
     case VSCP_GET | VSCP_MSG_NICKNAME:
         message->value[1] = config_data[CONFIG_NICKNAME];
         message->length = 2;
@@ -143,6 +184,11 @@ void vscp_message_handler(vscp_message_t * message)
         swali_write_reg((message->value[1] << 8) | message->value[2], message->value[0], message->value[3]);    
         break;
                     
+    case VSCP_GET | VSCP_MSG_BOOT_ALG:
+        message->value[1] = VSCP_BOOTLOADER_PIC1;
+        message->length = 2;
+        break;
+
     case VSCP_GET | VSCP_MSG_PAGES_USED:
         message->value[1] = SWALI_NUM_INPUTS + SWALI_NUM_OUTPUTS;
         message->length = 2;
@@ -194,6 +240,28 @@ void vscp_message_handler(vscp_message_t * message)
         }
         break;
     
+    case VSCP_GET | VSCP_MSG_DMINFO:
+        if (message->value[0] < 4)
+        {
+            message->length = 2;
+            switch (message->value[0])
+            {
+            case 0: // rows
+                message->value[1] = SWALI_NUM_DM_ROWS;
+                break;
+            case 1: // offset
+                message->value[1] = SWALI_DM_REG;
+                break;
+            case 2: // page MSB
+                message->value[1] = (uint8_t) (SWALI_NODE_PAGE >> 8);
+                break;
+            case 3: // page LSB
+                message->value[1] = (uint8_t) SWALI_NODE_PAGE;
+                break;
+            }
+        }
+        break;
+
     case VSCP_GET | VSCP_MSG_FWVERSION:
         if (message->value[0] < 3)
         {
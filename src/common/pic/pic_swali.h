@@ -33,6 +33,7 @@ extern const uint16_t config_data_size;
 #define CONFIG_BOOT     0x00   // 0xFF = enter boot, 0xAA = valid data
 #define CONFIG_NICKNAME 0x01   // 0xFF is invalid
 #define CONFIG_UID      0x02   // 5 bytes
+#define CONFIG_HEARTBEAT 0x07  // heartbeat period in s, 0 = default
 #define CONFIG_SWALI    0x10   // start of swali config struct, max 240bytes
 
 
@@ -0,0 +1,202 @@
+/* 
+ * This file is part of Swali VSCP, https://www.github.com/swali_vscp.
+ * Copyright (c) 2020 Maarten Zanders.
+ * 
+ * This program is free software: you can redistribute it and/or modify  
+ * it under the terms of the GNU General Public License as published by  
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but 
+ * WITHOUT ANY WARRANTY; without even the implied warranty of 
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU 
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License 
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <xc.h>
+#include "pwm.h"
+#include "swali_config.h"
+
+/* Software PWM on the output pins. Timer1 runs at Fosc/4/8 = 1.25MHz, a
+ * period of 5000 ticks gives 250Hz. Rather than toggling each channel, the
+ * main loop turns the levels into a schedule of port writes: all active
+ * channels switch on at the start of the period and every following step
+ * switches off the channels with the next higher level. The interrupt
+ * only writes the ports and reloads the timer, so there are at most
+ * SWALI_NUM_OUTPUTS + 1 interrupts per period.
+ */
+#define PWM_PERIOD    5000
+#define PWM_MIN_STEP  25    // 20us, closer edges are merged
+#define NUM_STEPS     (SWALI_NUM_OUTPUTS + 1)
+
+typedef struct {
+    uint16_t reload; // timer value giving the duration of this step
+    uint8_t portb;
+    uint8_t portc;
+} pwm_step_t;
+
+typedef struct {
+    pwm_step_t step[NUM_STEPS];
+    uint8_t num_steps;
+    uint8_t mask_b; // pins driven by the schedule
+    uint8_t mask_c;
+} pwm_schedule_t;
+
+/* The interrupt runs from schedule[active], a new schedule is prepared in
+ * the other one and taken at the start of the next period.
+ */
+static pwm_schedule_t schedule[2];
+static volatile uint8_t active;
+static volatile uint8_t pending;
+static uint8_t current_step;
+
+static uint8_t level[SWALI_NUM_OUTPUTS];
+static uint8_t enabled; // one bit per output
+static uint8_t dirty;
+
+static uint16_t edge(uint8_t value);
+
+void pwm_init(void)
+{
+    schedule[0].step[0].reload = (uint16_t) (0x10000UL - PWM_PERIOD);
+    schedule[0].num_steps = 1;
+    active = 0;
+    pending = 0;
+    current_step = 0;
+    enabled = 0;
+    dirty = 0;
+
+    T1CON = 0xB1; // 16 bit access, prescaler 1:8, internal clock, on
+    IPR1bits.TMR1IP = 1;
+    PIE1bits.TMR1IE = 1;
+}
+
+void pwm_set(uint8_t id, uint8_t value)
+{
+    if (!(enabled & (1 << id)) || (level[id] != value))
+    {
+        enabled |= 1 << id;
+        level[id] = value;
+        dirty = 1;
+    }
+}
+
+void pwm_release(uint8_t id)
+{
+    if (enabled & (1 << id))
+    {
+        enabled &= ~(1 << id);
+        dirty = 1;
+    }
+}
+
+void pwm_process(void)
+{
+    pwm_schedule_t * s;
+    pwm_step_t * step;
+    uint8_t order[SWALI_NUM_OUTPUTS];
+    uint8_t num_order = 0;
+    uint16_t start = 0;
+    uint16_t at;
+    uint8_t j;
+
+    // the interrupt did not take the previous one yet
+    if (!dirty || pending)
+        return;
+
+    s = &schedule[!active];
+    step = &s->step[0];
+    step->portb = 0;
+    step->portc = 0;
+    s->mask_b = 0;
+    s->mask_c = 0;
+
+    for (uint8_t i = 0; i < SWALI_NUM_OUTPUTS; i++)
+    {
+        if (!(enabled & (1 << i)))
+            continue;
+
+        if (pwm_pins[i].port == PWM_PORTB)
+            s->mask_b |= pwm_pins[i].mask;
+        else
+            s->mask_c |= pwm_pins[i].mask;
+
+        if (level[i] == 0)
+            continue;
+
+        if (pwm_pins[i].port == PWM_PORTB)
+            step->portb |= pwm_pins[i].mask;
+        else
+            step->portc |= pwm_pins[i].mask;
+
+        // channels switching off during the period, sorted on level
+        if (level[i] < 255)
+        {
+            for (j = num_order; (j > 0) && (level[order[j - 1]] > level[i]); j--)
+                order[j] = order[j - 1];
+            order[j] = i;
+            num_order++;
+        }
+    }
+
+    s->num_steps = 1;
+    for (j = 0; j < num_order; j++)
+    {
+        at = edge(level[order[j]]);
+        if (at - start >= PWM_MIN_STEP)
+        {
+            step->reload = (uint16_t) (0x10000UL - (at - start));
+            step[1] = step[0];
+            step++;
+            s->num_steps++;
+            start = at;
+        }
+        if (pwm_pins[order[j]].port == PWM_PORTB)
+            step->portb &= ~pwm_pins[order[j]].mask;
+        else
+            step->portc &= ~pwm_pins[order[j]].mask;
+    }
+    step->reload = (uint16_t) (0x10000UL - (PWM_PERIOD - start));
+
+    dirty = 0;
+    pending = 1;
+}
+
+void pwm_service(void)
+{
+    pwm_schedule_t * s;
+    pwm_step_t * step;
+
+    if ((current_step == 0) && pending)
+    {
+        active = !active;
+        pending = 0;
+    }
+
+    s = &schedule[active];
+    step = &s->step[current_step];
+
+    TMR1H = (uint8_t) (step->reload >> 8);
+    TMR1L = (uint8_t) step->reload;
+    LATB = (LATB & ~s->mask_b) | step->portb;
+    LATC = (LATC & ~s->mask_c) | step->portc;
+
+    if (++current_step >= s->num_steps)
+        current_step = 0;
+}
+
+/* Point in the period where a channel at this level switches off. The
+ * quadratic curve gives a more even perceived brightness.
+ */
+static uint16_t edge(uint8_t value)
+{
+    uint16_t at = (uint16_t) ((uint32_t) value * value * PWM_PERIOD / (255UL * 255));
+
+    if (at < PWM_MIN_STEP)
+        at = PWM_MIN_STEP;
+    if (at > PWM_PERIOD - PWM_MIN_STEP)
+        at = PWM_PERIOD - PWM_MIN_STEP;
+    return at;
+}
@@ -0,0 +1,52 @@
+/* 
+ * This file is part of Swali VSCP, https://www.github.com/swali_vscp.
+ * Copyright (c) 2020 Maarten Zanders.
+ * 
+ * This program is free software: you can redistribute it and/or modify  
+ * it under the terms of the GNU General Public License as published by  
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but 
+ * WITHOUT ANY WARRANTY; without even the implied warranty of 
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU 
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License 
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _PWM_H_
+#define	_PWM_H_
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define PWM_PORTB 0
+#define PWM_PORTC 1
+
+    typedef struct {
+        uint8_t port;
+        uint8_t mask;
+    } pwm_pin_t;
+
+    // pin of every output channel, provided by the board
+    extern const pwm_pin_t pwm_pins[];
+
+    void pwm_init(void);
+    // put an output under PWM control at level 0..255
+    void pwm_set(uint8_t id, uint8_t level);
+    // hand the output back to discrete_write()
+    void pwm_release(uint8_t id);
+    // call from the main loop, prepares the next schedule after changes
+    void pwm_process(void);
+    // call from the high priority interrupt on TMR1IF
+    void pwm_service(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _PWM_H_ */
@@ -19,10 +19,61 @@
 #include "swali_config.h"
 #include "swali_input.h"
 #include "swali_output.h"
+#include "swali_dm.h"
+#include "swali_timer.h"
 #include "systick.h"
+#include "time.h"
 
 #define NUM_CHANNELS (SWALI_NUM_INPUTS + SWALI_NUM_OUTPUTS)
 
+#define NODE_FLAG_COALESCE 0x01
+
+// bump when the layout of the stored configuration changes
+#define CONFIG_LAYOUT 1
+
+/* Register map of the node page (SWALI_NODE_PAGE) */
+#define NODE_REG_ID0       0x00 // read only
+#define NODE_REG_ID1       0x01 // read only
+#define NODE_REG_VERSION   0x02 // read only
+#define NODE_REG_COALESCE  0x03 // R/W  1 = aggregate output state reports
+#define NODE_REG_HOLDOFF   0x04 // R/W  coalescing window, units of 10ms
+#define NODE_REG_ZONE      0x05 // R/W  zone of the node, for the DM
+#define NODE_REG_SUBZONE   0x06 // R/W  subzone of the node, for the DM
+#define NODE_REG_RAMP      0x07 // R/W  dimmer ramp time, units of 100ms
+#define NODE_REG_REPEAT    0x08 // R/W  input hold repeat time, units of 10ms
+#define NODE_REG_SCENE     0x20 // R/W  scene table, 4 registers per scene:
+                                //      id (0 = unused), output mask,
+                                //      target states MSB, LSB
+                                // SWALI_DM_REG: decision matrix, 8 per row
+
+/* A scene drives any of the outputs to a target state in one go. The target
+ * state (0 = off, 1 = on, 2 = fast flash, 3 = slow flash) of output n is
+ * found at bits 2n+1..2n of states.
+ */
+typedef struct
+{
+    uint8_t id;
+    uint8_t mask;
+    uint16_t states;
+} swali_scene_t;
+
+typedef struct
+{
+    uint8_t flags;
+    uint8_t holdoff;
+    uint8_t zone;
+    uint8_t subzone;
+    uint8_t layout;
+#if SWALI_NUM_SCENES > 0
+    swali_scene_t scene[SWALI_NUM_SCENES];
+#endif
+#if SWALI_NUM_DM_ROWS > 0
+    swali_dm_row_t dm[SWALI_NUM_DM_ROWS];
+#endif
+    uint8_t ramp;
+    uint8_t repeat;
+} swali_node_config_t;
+
 typedef struct
 {
 #if SWALI_NUM_INPUTS > 0
@@ -31,6 +82,13 @@ typedef struct
 #if SWALI_NUM_OUTPUTS > 0
     swali_output_config_t output[SWALI_NUM_OUTPUTS];
 #endif /* SWALI_NUM_OUTPUTS > 0 */  
+    swali_node_config_t node;
+#if SWALI_NUM_INPUTS > 0
+    swali_input_timing_t input_timing[SWALI_NUM_INPUTS];
+#endif /* SWALI_NUM_INPUTS > 0 */
+#if SWALI_NUM_OUTPUTS > 0
+    uint8_t output_level[SWALI_NUM_OUTPUTS];
+#endif /* SWALI_NUM_OUTPUTS > 0 */
 } swali_config_t;
 
 swali_config_t * config;
@@ -47,6 +105,20 @@ typedef struct
 
 swali_data_t data;
 
+/* channels with a state report waiting to be coalesced, one bit per channel */
+static uint16_t coalesce_pending;
+static uint16_t coalesce_start;
+
+/* Bulk state query: CLASS1_CONTROL SYNC with data[0] the nickname of the
+ * node or 0xFF for all nodes. The reply is the aggregated state event of
+ * all channels. Replies to a broadcast are spread out by nickname.
+ */
+#define SYNC_ALL_NODES 0xFF
+#define SYNC_SLOT_MS   2
+static uint8_t sync_pending;
+static uint16_t sync_start;
+static uint16_t sync_delay;
+
 typedef enum
 {
     input, output, undefined
@@ -57,6 +129,14 @@ uint8_t type_index(uint8_t swali_channel);
 
 void swali_service_tick(void);
 
+static void flush_coalesced_states(void);
+static void reply_sync(void);
+static void send_state_event(uint16_t channels);
+static void activate_scene(uint8_t id);
+static void dm_action(uint8_t action, uint8_t param);
+static uint8_t node_read_reg(uint8_t reg);
+static void node_write_reg(uint8_t reg, uint8_t value);
+
 void swali_init(uint8_t *configuration, uint8_t max_config_size)
 {
     if (sizeof (swali_config_t) > max_config_size)
@@ -67,27 +147,50 @@ void swali_init(uint8_t *configuration, uint8_t max_config_size)
     }
     config = (swali_config_t *) configuration;
 
+    if (config->node.layout != CONFIG_LAYOUT)
+    {
+#if SWALI_NUM_OUTPUTS > 0
+        for (uint8_t i = 0; i < SWALI_NUM_OUTPUTS; i++)
+            swali_output_upgrade_config(&config->output[i]);
+#endif
+        config->node.layout = CONFIG_LAYOUT;
+    }
+
     for (uint8_t i = 0; i < NUM_CHANNELS; i++)
     {
         switch (channel_type(i))
         {
         case input:
 #if SWALI_NUM_INPUTS > 0
-            swali_input_initialize(i, &config->input[type_index(i)], &data.input[type_index(i)]);
+            swali_input_initialize(i, &config->input[type_index(i)],
+                                   &config->input_timing[type_index(i)],
+                                   &data.input[type_index(i)]);
 #endif
             break;
         case output:
 #if SWALI_NUM_OUTPUTS > 0
-            swali_output_initialize(i, &config->output[type_index(i)], &data.output[type_index(i)]);
+            swali_output_initialize(i, &config->output[type_index(i)],
+                                    &config->output_level[type_index(i)],
+                                    &data.output[type_index(i)]);
 #endif /* SWALI_NUM_OUTPUTS > 0 */
             break;
         }
     }
+#if SWALI_NUM_DM_ROWS > 0
+    swali_dm_initialize(config->node.dm);
+#endif
     systick_register(swali_service_tick);
 }
 
 void swali_process(void)
 {
+#if SWALI_NUM_OUTPUTS > 0
+    uint8_t expired;
+
+    while ((expired = swali_timer_expired()) != SWALI_TIMER_NONE)
+        swali_output_timer_expired(&data.output[type_index(expired)]);
+#endif
+
     for (uint8_t i = 0; i < NUM_CHANNELS; i++)
     {
         switch (channel_type(i))
@@ -104,6 +207,8 @@ void swali_process(void)
             break;
         }
     }
+    flush_coalesced_states();
+    reply_sync();
 }
 
 void swali_send_event(vscp_event_t * event)
@@ -116,6 +221,36 @@ void swali_send_event(vscp_event_t * event)
 
 void swali_event_handler(vscp_event_t * event)
 {
+    // scenes are identified by an installation wide id, zone/subzone unused
+    if ((event->vscp_class == VSCP_CLASS1_CONTROL) &&
+            (event->vscp_type == VSCP_TYPE_CONTROL_SET_PRESET) &&
+            (event->size == 3))
+    {
+        activate_scene(event->data[0]);
+    }
+
+    if ((event->vscp_class == VSCP_CLASS1_CONTROL) &&
+            (event->vscp_type == VSCP_TYPE_CONTROL_SYNC) &&
+            (event->size >= 1))
+    {
+        if (event->data[0] == vscp_get_nickname())
+        {
+            sync_pending = 1;
+            sync_delay = 0;
+            sync_start = time_get_ms();
+        }
+        else if (event->data[0] == SYNC_ALL_NODES)
+        {
+            sync_pending = 1;
+            sync_delay = (uint16_t) vscp_get_nickname() * SYNC_SLOT_MS;
+            sync_start = time_get_ms();
+        }
+    }
+
+#if SWALI_NUM_DM_ROWS > 0
+    swali_dm_handle_event(event, config->node.zone, config->node.subzone, dm_action);
+#endif
+
     for (uint8_t i = 0; i < NUM_CHANNELS; i++)
     {
         switch (channel_type(i))
@@ -134,10 +269,43 @@ void swali_event_handler(vscp_event_t * event)
     }
 }
 
+uint8_t swali_coalesce_state(uint8_t swali_channel)
+{
+    if (!(config->node.flags & NODE_FLAG_COALESCE))
+        return 0;
+
+    // the holdoff window starts with the first report
+    if (coalesce_pending == 0)
+        coalesce_start = time_get_ms();
+    coalesce_pending |= ((uint16_t) 1 << swali_channel);
+    return 1;
+}
+
+void swali_publish_state(void)
+{
+    sync_pending = 1;
+    sync_delay = 0;
+    sync_start = time_get_ms();
+}
+
+uint8_t swali_ramp_time(void)
+{
+    return config->node.ramp;
+}
+
+uint8_t swali_repeat_time(void)
+{
+    return config->node.repeat;
+}
+
 uint8_t swali_read_reg(uint16_t page, uint8_t reg)
 {
     uint8_t rv = 0;
-    if (page < NUM_CHANNELS)
+    if (page == SWALI_NODE_PAGE)
+    {
+        rv = node_read_reg(reg);
+    }
+    else if (page < NUM_CHANNELS)
     {
         switch (channel_type(page))
         {
@@ -158,7 +326,11 @@ uint8_t swali_read_reg(uint16_t page, uint8_t reg)
 
 void swali_write_reg(uint16_t page, uint8_t reg, uint8_t value)
 {
-    if (page < NUM_CHANNELS)
+    if (page == SWALI_NODE_PAGE)
+    {
+        node_write_reg(reg, value);
+    }
+    else if (page < NUM_CHANNELS)
     {
         switch (channel_type(page))
         {
@@ -176,6 +348,286 @@ void swali_write_reg(uint16_t page, uint8_t reg, uint8_t value)
     }
 }
 
+static void flush_coalesced_states(void)
+{
+    uint16_t pending = coalesce_pending;
+    uint8_t count = 0;
+    uint8_t last = 0;
+
+    if (pending == 0)
+        return;
+
+    if ((uint16_t) (time_get_ms() - coalesce_start) <
+            (uint16_t) config->node.holdoff * 10)
+        return;
+
+    coalesce_pending = 0;
+
+    for (uint8_t i = 0; i < NUM_CHANNELS; i++)
+    {
+        if (pending & ((uint16_t) 1 << i))
+        {
+            count++;
+            last = i;
+        }
+    }
+
+    // a lone change goes out as a plain ON/OFF event, so slaves following
+    // this zone/subzone stay synchronized
+    if ((count == 1) && (channel_type(last) == output))
+    {
+#if SWALI_NUM_OUTPUTS > 0
+        swali_output_report_state(&data.output[type_index(last)]);
+#endif
+    }
+    else
+    {
+        send_state_event(pending);
+    }
+}
+
+static void reply_sync(void)
+{
+    if (!sync_pending ||
+            ((uint16_t) (time_get_ms() - sync_start) < sync_delay))
+        return;
+
+    sync_pending = 0;
+    send_state_event((uint16_t) ((1UL << NUM_CHANNELS) - 1));
+}
+
+/* Aggregated state event, one per group of 8 channels:
+ *   data[0] = first channel of the group (bit 0 in the masks below)
+ *   data[1] = 255, data[2] = 255 (all zones/subzones, ignored by slaves)
+ *   data[3] = mask of the channels reported in this event
+ *   data[4] = mask of the channels which are on (inputs: active)
+ *   data[5] = mask of the channels which are flashing
+ */
+static void send_state_event(uint16_t channels)
+{
+    vscp_event_t tx_event;
+    uint8_t state;
+    uint8_t bit;
+
+    tx_event.priority = VSCP_PRIORITY_MEDIUM;
+    tx_event.vscp_class = VSCP_CLASS1_INFORMATION;
+    tx_event.vscp_type = VSCP_TYPE_INFORMATION_STATE;
+    tx_event.size = 6;
+    tx_event.data[1] = 255;
+    tx_event.data[2] = 255;
+
+    for (uint8_t base = 0; base < NUM_CHANNELS; base += 8)
+    {
+        tx_event.data[0] = base;
+        tx_event.data[3] = 0;
+        tx_event.data[4] = 0;
+        tx_event.data[5] = 0;
+
+        for (uint8_t i = base; (i < base + 8) && (i < NUM_CHANNELS); i++)
+        {
+            if (!(channels & ((uint16_t) 1 << i)))
+                continue;
+
+            state = 0;
+            switch (channel_type(i))
+            {
+            case input:
+#if SWALI_NUM_INPUTS > 0
+                state = swali_input_state(&data.input[type_index(i)]);
+#endif
+                break;
+            case output:
+#if SWALI_NUM_OUTPUTS > 0
+                state = swali_output_state(&data.output[type_index(i)]);
+#endif
+                break;
+            }
+            bit = 1 << (i - base);
+            tx_event.data[3] |= bit;
+            if (state)
+                tx_event.data[4] |= bit;
+            if (state > 1)
+                tx_event.data[5] |= bit;
+        }
+
+        if (tx_event.data[3])
+            swali_send_event(&tx_event);
+    }
+}
+
+static void activate_scene(uint8_t id)
+{
+#if SWALI_NUM_SCENES > 0
+    swali_scene_t * scene;
+
+    if (id == 0)
+        return;
+
+    for (uint8_t i = 0; i < SWALI_NUM_SCENES; i++)
+    {
+        scene = &config->node.scene[i];
+        if (scene->id != id)
+            continue;
+
+        for (uint8_t j = 0; j < SWALI_NUM_OUTPUTS; j++)
+        {
+            if (scene->mask & (1 << j))
+                swali_output_set_state(&data.output[j], (scene->states >> (2 * j)) & 0x03);
+        }
+    }
+#endif
+}
+
+static void dm_action(uint8_t action, uint8_t param)
+{
+#if SWALI_NUM_OUTPUTS > 0
+    swali_output_data_t * output;
+
+    if (action == SWALI_DM_ACTION_SCENE)
+    {
+        activate_scene(param);
+        return;
+    }
+
+    for (uint8_t i = 0; i < SWALI_NUM_OUTPUTS; i++)
+    {
+        if (!(param & (1 << i)))
+            continue;
+
+        output = &data.output[i];
+        switch (action)
+        {
+        case SWALI_DM_ACTION_TURN_ON:
+            swali_output_set_state(output, 1);
+            break;
+        case SWALI_DM_ACTION_TURN_OFF:
+            swali_output_set_state(output, 0);
+            break;
+        case SWALI_DM_ACTION_TOGGLE:
+            swali_output_set_state(output, swali_output_state(output) ? 0 : 1);
+            break;
+        }
+    }
+#endif
+}
+
+static uint8_t node_read_reg(uint8_t reg)
+{
+    uint8_t value = 0;
+
+#if SWALI_NUM_DM_ROWS > 0
+    if (reg >= SWALI_DM_REG)
+        return swali_dm_read_reg(reg - SWALI_DM_REG);
+#endif
+
+#if SWALI_NUM_SCENES > 0
+    if ((reg >= NODE_REG_SCENE) && (reg < NODE_REG_SCENE + 4 * SWALI_NUM_SCENES))
+    {
+        swali_scene_t * scene = &config->node.scene[(reg - NODE_REG_SCENE) / 4];
+        switch ((reg - NODE_REG_SCENE) % 4)
+        {
+        case 0:
+            return scene->id;
+        case 1:
+            return scene->mask;
+        case 2:
+            return (uint8_t) (scene->states >> 8);
+        default:
+            return (uint8_t) scene->states;
+        }
+    }
+#endif
+
+    switch (reg)
+    {
+    case NODE_REG_ID0:
+        value = 'N';
+        break;
+    case NODE_REG_ID1:
+        value = 'D';
+        break;
+    case NODE_REG_VERSION:
+        value = 0;
+        break;
+    case NODE_REG_COALESCE:
+        value = (config->node.flags & NODE_FLAG_COALESCE) ? 1 : 0;
+        break;
+    case NODE_REG_HOLDOFF:
+        value = config->node.holdoff;
+        break;
+    case NODE_REG_ZONE:
+        value = config->node.zone;
+        break;
+    case NODE_REG_SUBZONE:
+        value = config->node.subzone;
+        break;
+    case NODE_REG_RAMP:
+        value = config->node.ramp;
+        break;
+    case NODE_REG_REPEAT:
+        value = config->node.repeat;
+        break;
+    }
+    return value;
+}
+
+static void node_write_reg(uint8_t reg, uint8_t value)
+{
+#if SWALI_NUM_DM_ROWS > 0
+    if (reg >= SWALI_DM_REG)
+    {
+        swali_dm_write_reg(reg - SWALI_DM_REG, value);
+        return;
+    }
+#endif
+#if SWALI_NUM_SCENES > 0
+    if ((reg >= NODE_REG_SCENE) && (reg < NODE_REG_SCENE + 4 * SWALI_NUM_SCENES))
+    {
+        swali_scene_t * scene = &config->node.scene[(reg - NODE_REG_SCENE) / 4];
+        switch ((reg - NODE_REG_SCENE) % 4)
+        {
+        case 0:
+            scene->id = value;
+            break;
+        case 1:
+            scene->mask = value;
+            break;
+        case 2:
+            scene->states = (scene->states & 0x00FF) | ((uint16_t) value << 8);
+            break;
+        default:
+            scene->states = (scene->states & 0xFF00) | value;
+            break;
+        }
+        return;
+    }
+#endif
+    switch (reg)
+    {
+    case NODE_REG_COALESCE:
+        if (value)
+            config->node.flags |= NODE_FLAG_COALESCE;
+        else
+            config->node.flags &= ~NODE_FLAG_COALESCE;
+        break;
+    case NODE_REG_HOLDOFF:
+        config->node.holdoff = value;
+        break;
+    case NODE_REG_ZONE:
+        config->node.zone = value;
+        break;
+    case NODE_REG_SUBZONE:
+        config->node.subzone = value;
+        break;
+    case NODE_REG_RAMP:
+        config->node.ramp = value;
+        break;
+    case NODE_REG_REPEAT:
+        config->node.repeat = value;
+        break;
+    }
+}
+
 void swali_service_tick(void)
 {
     static uint8_t counter = 0;
@@ -25,6 +25,11 @@ extern "C"
 
 #include <stdint.h>
 #include "vscp.h"
+
+// page holding the node wide registers, outside the range of channel pages
+#define SWALI_NODE_PAGE 0x0100
+// first register of the decision matrix on the node page
+#define SWALI_DM_REG    0x40
     
 void swali_init(uint8_t *configuration, uint8_t max_config_size);
 
@@ -36,6 +41,19 @@ void swali_send_event(vscp_event_t *event);
 // incoming events (and internally generated events) go here
 void swali_event_handler(vscp_event_t * event);
 
+// channels report a change of their state here. Returns 1 when the report is
+// held back to be sent as part of an aggregated state event, 0 when the
+// channel should send its own information event right away.
+uint8_t swali_coalesce_state(uint8_t swali_channel);
+// ramp time of dimmed outputs for a full sweep, units of 100ms
+uint8_t swali_ramp_time(void);
+// repeat interval while holding an input, units of 10ms (0 = no repeat,
+// dimmer inputs then fall back to a fixed interval)
+uint8_t swali_repeat_time(void);
+
+// send the state of all channels from the next swali_process()
+void swali_publish_state(void);
+
 // reading and writing to VSCP registers
 uint8_t swali_read_reg(uint16_t page, uint8_t reg);
 void swali_write_reg(uint16_t page, uint8_t reg, uint8_t value);
@@ -0,0 +1,128 @@
+/* 
+ * This file is part of Swali VSCP, https://www.github.com/swali_vscp.
+ * Copyright (c) 2020 Maarten Zanders.
+ * 
+ * This program is free software: you can redistribute it and/or modify  
+ * it under the terms of the GNU General Public License as published by  
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but 
+ * WITHOUT ANY WARRANTY; without even the implied warranty of 
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU 
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License 
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "swali_dm.h"
+
+#define FLAG_ENABLE         0x80
+#define FLAG_CHECK_OADDR    0x40
+#define FLAG_HARDCODED      0x20 // not supported, hardcoded nodes are ignored
+#define FLAG_MATCH_ZONE     0x10
+#define FLAG_MATCH_SUBZONE  0x08
+#define FLAG_CLASS_MASK8    0x02 // bit 8 of the class mask
+#define FLAG_CLASS_FILTER8  0x01 // bit 8 of the class filter
+
+/* Rows in EEPROM are compiled into this structure whenever they change, so
+ * matching an event only takes a few compares for the enabled rows.
+ */
+typedef struct {
+    uint16_t class_mask;
+    uint16_t class_filter; // already masked
+    uint8_t type_mask;
+    uint8_t type_filter;   // already masked
+    uint8_t oaddr;
+    uint8_t flags;
+    uint8_t row;
+} swali_dm_match_t;
+
+static swali_dm_row_t * rows_;
+static swali_dm_match_t match[SWALI_NUM_DM_ROWS];
+static uint8_t num_match;
+
+static void compile(void);
+
+void swali_dm_initialize(swali_dm_row_t * rows)
+{
+    rows_ = rows;
+    compile();
+}
+
+void swali_dm_handle_event(vscp_event_t * event, uint8_t zone, uint8_t subzone,
+                           void (*action)(uint8_t action, uint8_t param))
+{
+    swali_dm_match_t * m;
+    // aggregated state reports carry 255 as "no zone", not as "all zones"
+    uint8_t wildcard = (event->vscp_class != VSCP_CLASS1_INFORMATION) ||
+            (event->vscp_type != VSCP_TYPE_INFORMATION_STATE);
+
+    for (uint8_t i = 0; i < num_match; i++)
+    {
+        m = &match[i];
+
+        if ((event->vscp_class & m->class_mask) != m->class_filter)
+            continue;
+        if ((event->vscp_type & m->type_mask) != m->type_filter)
+            continue;
+        if ((m->flags & FLAG_CHECK_OADDR) && (event->nickname != m->oaddr))
+            continue;
+        if ((m->flags & FLAG_MATCH_ZONE) &&
+                ((event->size < 2) ||
+                ((event->data[1] != zone) && (!wildcard || (event->data[1] != 255)))))
+            continue;
+        if ((m->flags & FLAG_MATCH_SUBZONE) &&
+                ((event->size < 3) ||
+                ((event->data[2] != subzone) && (!wildcard || (event->data[2] != 255)))))
+            continue;
+
+        action(rows_[m->row].action, rows_[m->row].action_param);
+    }
+}
+
+void swali_dm_write_reg(uint8_t reg, uint8_t value)
+{
+    if (reg < SWALI_NUM_DM_ROWS * SWALI_DM_ROW_SIZE)
+    {
+        ((uint8_t *) rows_)[reg] = value;
+        compile();
+    }
+}
+
+uint8_t swali_dm_read_reg(uint8_t reg)
+{
+    uint8_t value = 0;
+
+    if (reg < SWALI_NUM_DM_ROWS * SWALI_DM_ROW_SIZE)
+        value = ((uint8_t *) rows_)[reg];
+    return value;
+}
+
+static void compile(void)
+{
+    swali_dm_row_t * row;
+    swali_dm_match_t * m;
+
+    num_match = 0;
+    for (uint8_t i = 0; i < SWALI_NUM_DM_ROWS; i++)
+    {
+        row = &rows_[i];
+        if (!(row->flags & FLAG_ENABLE) || (row->action == SWALI_DM_ACTION_NOOP))
+            continue;
+
+        m = &match[num_match++];
+        m->class_mask = row->class_mask;
+        if (row->flags & FLAG_CLASS_MASK8)
+            m->class_mask |= 0x100;
+        m->class_filter = row->class_filter;
+        if (row->flags & FLAG_CLASS_FILTER8)
+            m->class_filter |= 0x100;
+        m->class_filter &= m->class_mask;
+        m->type_mask = row->type_mask;
+        m->type_filter = row->type_filter & row->type_mask;
+        m->oaddr = row->oaddr;
+        m->flags = row->flags;
+        m->row = i;
+    }
+}
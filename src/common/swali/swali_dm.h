@@ -0,0 +1,62 @@
+/* 
+ * This file is part of Swali VSCP, https://www.github.com/swali_vscp.
+ * Copyright (c) 2020 Maarten Zanders.
+ * 
+ * This program is free software: you can redistribute it and/or modify  
+ * it under the terms of the GNU General Public License as published by  
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but 
+ * WITHOUT ANY WARRANTY; without even the implied warranty of 
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU 
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License 
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _SWALI_DM_H_
+#define	_SWALI_DM_H_
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "swali_config.h"
+#include "vscp.h"
+
+/* Decision matrix, following the VSCP level I row layout (8 bytes/row) */
+#define SWALI_DM_ROW_SIZE         8
+
+/* Actions, the parameter is given between brackets */
+#define SWALI_DM_ACTION_NOOP      0x00
+#define SWALI_DM_ACTION_TURN_ON   0x01 // output mask
+#define SWALI_DM_ACTION_TURN_OFF  0x02 // output mask
+#define SWALI_DM_ACTION_TOGGLE    0x03 // output mask
+#define SWALI_DM_ACTION_SCENE     0x04 // scene id
+
+    typedef struct {
+        uint8_t oaddr;
+        uint8_t flags;
+        uint8_t class_mask;
+        uint8_t class_filter;
+        uint8_t type_mask;
+        uint8_t type_filter;
+        uint8_t action;
+        uint8_t action_param;
+    } swali_dm_row_t;
+
+    void swali_dm_initialize(swali_dm_row_t * rows);
+    // rows matching the event call back with their action; the callback is
+    // executed from within the event handler and must not send events
+    void swali_dm_handle_event(vscp_event_t * event, uint8_t zone, uint8_t subzone,
+                               void (*action)(uint8_t action, uint8_t param));
+    // reg is relative to the first register of the matrix
+    void swali_dm_write_reg(uint8_t reg, uint8_t value);
+    uint8_t swali_dm_read_reg(uint8_t reg);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _SWALI_DM_H_ */
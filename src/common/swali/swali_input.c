@@ -26,6 +26,9 @@ static void input_debounce(void);
 static void send_control_event(swali_input_data_t * data);
 static void send_button_event(swali_input_data_t * data, uint8_t state);
 static void send_info_event(swali_input_data_t * data, uint8_t state);
+static void send_gesture_event(swali_input_data_t * data, uint8_t type);
+static void send_dim_event(swali_input_data_t * data);
+static void process_gesture(swali_input_data_t * data, uint8_t edge);
 
 static void write_flag(swali_input_data_t * data, uint8_t flag, uint8_t value);
 static uint8_t read_flag(swali_input_data_t * data, uint8_t flag);
@@ -51,13 +54,41 @@ static uint8_t reg_range(uint8_t reg);
 #define REG_TYPE          0x22 // R/W  0 = pushbutton, 1 = toggle switch
 #define REG_INVERT        0x23 // R/W  1 = invert
 #define REG_TURN_ON_VALUE 0x24 // R/W  0 = normal, 1 = fast flash, 2 = slow flash
+#define REG_LONG_PRESS    0x25 // R/W  long press time x10ms, 0 = no gestures
+#define REG_DOUBLE_CLICK  0x26 // R/W  double click window x10ms, 0 = none
+#define REG_DIM           0x27 // R/W  1 = holding the button dims the zone
 
 #define SAMPLE_MODULUS    8
 
-void swali_input_initialize(uint8_t swali_channel, swali_input_config_t * config, swali_input_data_t * data)
+/* Gestures, evaluated from the debounced edges in the main loop:
+ *   press - release                   > SINGLE_CLICK
+ *   press - release - press - release > DOUBLE_CLICK (within the window)
+ *   press - hold                      > LONG_CLICK, then every repeat
+ *                                       interval DIM_LAMPS for dimmer
+ *                                       inputs or another LONG_CLICK
+ * A single click is only reported after the double click window closed,
+ * so double clicks cost latency and are off unless configured.
+ */
+#define GESTURE_IDLE      0
+#define GESTURE_PRESSED   1
+#define GESTURE_HELD      2
+#define GESTURE_RELEASED  3 // waiting for a second press
+#define GESTURE_SECOND    4
+
+#define DIM_REPEAT_MS     250 // DIM_LAMPS interval without a node repeat time
+
+#define EDGE_NONE         0
+#define EDGE_PRESS        1
+#define EDGE_RELEASE      2
+
+void swali_input_initialize(uint8_t swali_channel, swali_input_config_t * config,
+                            swali_input_timing_t * timing, swali_input_data_t * data)
 {
     data->swali_channel = swali_channel;
     data->config = config;
+    data->timing = timing;
+    data->gesture = GESTURE_IDLE;
+    data->dim_up = 0;
     data->state = 0;
     data->last_switch_state = 0;
     data->switch_shifter = 0;
@@ -65,17 +96,23 @@ void swali_input_initialize(uint8_t swali_channel, swali_input_config_t * config
 
 void swali_input_process(swali_input_data_t * data)
 {
+    uint8_t edge = EDGE_NONE;
+    // dimmer buttons toggle on a click, holding them dims
+    uint8_t toggle_on_click = (data->config->flags & FLAG_TYPE_DIM) &&
+            data->timing->long_press && !(data->config->flags & FLAG_TYPE_TOGGLE);
+
     // switch goes high
     if (!data->last_switch_state && (data->switch_shifter == 0xFF))
     {
         // always send button press event
         send_button_event(data, 1);
         if ((data->config->flags & FLAG_ENABLE) && 
-                (data->config->zone != 0xFF))
+                (data->config->zone != 0xFF) && !toggle_on_click)
         {
             send_control_event(data);
         }
         data->last_switch_state = 1;
+        edge = EDGE_PRESS;
     }
 
     // switch goes low
@@ -90,6 +127,95 @@ void swali_input_process(swali_input_data_t * data)
             send_control_event(data);
         }
         data->last_switch_state = 0;
+        edge = EDGE_RELEASE;
+    }
+
+    // gestures only make sense for push buttons
+    if ((data->config->flags & FLAG_ENABLE) && data->timing->long_press &&
+            !(data->config->flags & FLAG_TYPE_TOGGLE))
+    {
+        process_gesture(data, edge);
+    }
+}
+
+static void process_gesture(swali_input_data_t * data, uint8_t edge)
+{
+    uint16_t now = time_get_ms();
+    uint16_t elapsed = now - data->gesture_ms;
+    uint16_t repeat = (uint16_t) swali_repeat_time() * 10;
+
+    // holding a dimmer button always dims, also with repeats turned off
+    if (!repeat && (data->config->flags & FLAG_TYPE_DIM))
+        repeat = DIM_REPEAT_MS;
+
+    switch (data->gesture)
+    {
+    case GESTURE_IDLE:
+        if (edge == EDGE_PRESS)
+        {
+            data->gesture = GESTURE_PRESSED;
+            data->gesture_ms = now;
+        }
+        break;
+
+    case GESTURE_PRESSED:
+        if (edge == EDGE_RELEASE)
+        {
+            if (data->timing->double_click)
+            {
+                data->gesture = GESTURE_RELEASED;
+                data->gesture_ms = now;
+            }
+            else
+            {
+                data->gesture = GESTURE_IDLE;
+                send_gesture_event(data, VSCP_TYPE_INFORMATION_SINGLE_CLICK);
+            }
+        }
+        else if (elapsed >= (uint16_t) data->timing->long_press * 10)
+        {
+            data->gesture = GESTURE_HELD;
+            data->gesture_ms = now;
+            // dim up from off, otherwise the other way than last time
+            data->dim_up = data->state ? !data->dim_up : 1;
+            send_gesture_event(data, VSCP_TYPE_INFORMATION_LONG_CLICK);
+        }
+        break;
+
+    case GESTURE_HELD:
+        if (edge == EDGE_RELEASE)
+        {
+            data->gesture = GESTURE_IDLE;
+        }
+        else if (repeat && (elapsed >= repeat))
+        {
+            data->gesture_ms += repeat;
+            if (data->config->flags & FLAG_TYPE_DIM)
+                send_dim_event(data);
+            else
+                send_gesture_event(data, VSCP_TYPE_INFORMATION_LONG_CLICK);
+        }
+        break;
+
+    case GESTURE_RELEASED:
+        if (edge == EDGE_PRESS)
+        {
+            data->gesture = GESTURE_SECOND;
+        }
+        else if (elapsed >= (uint16_t) data->timing->double_click * 10)
+        {
+            data->gesture = GESTURE_IDLE;
+            send_gesture_event(data, VSCP_TYPE_INFORMATION_SINGLE_CLICK);
+        }
+        break;
+
+    case GESTURE_SECOND:
+        if (edge == EDGE_RELEASE)
+        {
+            data->gesture = GESTURE_IDLE;
+            send_gesture_event(data, VSCP_TYPE_INFORMATION_DOUBLE_CLICK);
+        }
+        break;
     }
 }
 
@@ -153,6 +279,20 @@ void swali_input_write_reg(swali_input_data_t * data, uint8_t reg, uint8_t value
     case REG_TURN_ON_VALUE:
         data->config->turn_on_value = value;
         break;
+
+    case REG_LONG_PRESS:
+        data->timing->long_press = value;
+        data->gesture = GESTURE_IDLE;
+        break;
+
+    case REG_DOUBLE_CLICK:
+        data->timing->double_click = value;
+        data->gesture = GESTURE_IDLE;
+        break;
+
+    case REG_DIM:
+        write_flag(data, FLAG_TYPE_DIM, value);
+        break;
             
     }
 }
@@ -200,10 +340,25 @@ uint8_t swali_input_read_reg(swali_input_data_t * data, uint8_t reg)
     case REG_TURN_ON_VALUE:
         value = data->config->turn_on_value;
         break;
+    case REG_LONG_PRESS:
+        value = data->timing->long_press;
+        break;
+    case REG_DOUBLE_CLICK:
+        value = data->timing->double_click;
+        break;
+    case REG_DIM:
+        value = read_flag(data, FLAG_TYPE_DIM);
+        break;
     }
     return value;
 }
 
+// debounced state of the input itself
+uint8_t swali_input_state(swali_input_data_t * data)
+{
+    return data->last_switch_state;
+}
+
 static void send_control_event(swali_input_data_t * data)
 {
     vscp_event_t tx_event;
@@ -228,18 +383,19 @@ static void send_control_event(swali_input_data_t * data)
 static void send_button_event(swali_input_data_t * data, uint8_t state)
 {
     vscp_event_t tx_event;
+    const vscp4hass_bs_class_t * bs_class;
     uint8_t class_id = data->config->class_id;
     
     // send event for the configured class ID
     if (class_id > VSCP4HASS_BS_MAX_CLASS_ID)
         return;
     
-// temporary only send simple ON/OFF events
-    tx_event.vscp_class = vscp4hass_bs_class_map[0].vscp_class;
+    bs_class = &vscp4hass_bs_class_map[class_id];
+    tx_event.vscp_class = bs_class->vscp_class;
     if(state)
-        tx_event.vscp_type = vscp4hass_bs_class_map[0].vscp_event_on;
+        tx_event.vscp_type = bs_class->vscp_event_on;
     else
-        tx_event.vscp_type = vscp4hass_bs_class_map[0].vscp_event_off;
+        tx_event.vscp_type = bs_class->vscp_event_off;
     
     tx_event.priority = VSCP_PRIORITY_MEDIUM;
     
@@ -251,6 +407,47 @@ static void send_button_event(swali_input_data_t * data, uint8_t state)
     swali_send_event(&tx_event);
 }
 
+static void send_gesture_event(swali_input_data_t * data, uint8_t type)
+{
+    vscp_event_t tx_event;
+
+    // a single click on a dimmer button toggles its zone
+    if ((type == VSCP_TYPE_INFORMATION_SINGLE_CLICK) &&
+            (data->config->flags & FLAG_TYPE_DIM) &&
+            (data->config->zone != 0xFF))
+    {
+        send_control_event(data);
+    }
+
+    tx_event.priority = VSCP_PRIORITY_MEDIUM;
+    tx_event.vscp_class = VSCP_CLASS1_INFORMATION;
+    tx_event.vscp_type = type;
+    tx_event.size = 3;
+    tx_event.data[0] = data->swali_channel;
+    tx_event.data[1] = data->config->zone;
+    tx_event.data[2] = data->config->subzone;
+
+    swali_send_event(&tx_event);
+}
+
+static void send_dim_event(swali_input_data_t * data)
+{
+    vscp_event_t tx_event;
+
+    if (data->config->zone == 0xFF)
+        return;
+
+    tx_event.priority = VSCP_PRIORITY_MEDIUM;
+    tx_event.vscp_class = VSCP_CLASS1_CONTROL;
+    tx_event.vscp_type = VSCP_TYPE_CONTROL_DIM_LAMPS;
+    tx_event.size = 3;
+    tx_event.data[0] = data->dim_up ? 255 : 254;
+    tx_event.data[1] = data->config->zone;
+    tx_event.data[2] = data->config->subzone;
+
+    swali_send_event(&tx_event);
+}
+
 void swali_input_service_tick(swali_input_data_t * data, uint8_t counter)
 {
     uint8_t discrete;
@@ -33,20 +33,32 @@ extern "C" {
         char name [SWALI_NAME_LENGTH];
     } swali_input_config_t;
 
+    // gesture timings, stored apart from swali_input_config_t
+    typedef struct {
+        uint8_t long_press;   // x10ms, 0 = no gestures
+        uint8_t double_click; // x10ms, 0 = no double clicks
+    } swali_input_timing_t;
+
     typedef struct {
         uint8_t swali_channel;
         uint8_t state;
         uint8_t last_state;
         uint8_t last_switch_state;
         uint8_t switch_shifter;
+        uint8_t gesture;
+        uint8_t dim_up;
+        uint16_t gesture_ms;
         swali_input_config_t * config;
+        swali_input_timing_t * timing;
     } swali_input_data_t;
 
-    void swali_input_initialize(uint8_t swali_channel, swali_input_config_t * config, swali_input_data_t * data);
+    void swali_input_initialize(uint8_t swali_channel, swali_input_config_t * config,
+                                swali_input_timing_t * timing, swali_input_data_t * data);
     void swali_input_process(swali_input_data_t * data);
     void swali_input_handle_event(swali_input_data_t * data, vscp_event_t * event);
     void swali_input_write_reg(swali_input_data_t * data, uint8_t reg, uint8_t value);
     uint8_t swali_input_read_reg(swali_input_data_t * data, uint8_t reg);
+    uint8_t swali_input_state(swali_input_data_t * data);
     void swali_input_service_tick(swali_input_data_t * data, uint8_t counter);
 
 #ifdef	__cplusplus
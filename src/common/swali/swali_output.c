@@ -3,19 +3,28 @@
 #include "discrete.h"
 #include "vscp.h"
 #include "swali_output.h"
+#include "swali_timer.h"
 #include "time.h"
+#include "pwm.h"
 
 static void send_info_event(swali_output_data_t * data);
 static void send_control_event(swali_output_data_t * data);
+static void send_level_event(swali_output_data_t * data);
 static void update_output(swali_output_data_t * data);
+static void ramp(swali_output_data_t * data, uint8_t target);
+static void set_level(swali_output_data_t * data, uint8_t level);
 static void write_flag(swali_output_data_t * data, uint8_t flag, uint8_t value);
 static uint8_t read_flag(swali_output_data_t * data, uint8_t flag);
 static uint8_t reg_range(uint8_t reg);
-static uint8_t timer_on(swali_output_data_t * data);
+static uint32_t elapsed(swali_output_data_t * data);
+static void set_on_time(swali_output_data_t * data, uint32_t seconds);
 
 #define FLAG_ENABLE       0x80
+#define FLAG_DIM          0x40
 #define FLAG_INVERT       0x20
 
+#define DIM_STEP          16   // level change for a DIM_LAMPS up/down
+
 #define REG_ID0           0x00 // read only
 #define REG_ID1           0x01 // read only
 #define REG_VERSION       0x02 // read only
@@ -25,71 +34,71 @@ static uint8_t timer_on(swali_output_data_t * data);
 #define REG_ZONE          0x06 // R/W
 #define REG_SUBZONE       0x07 // R/W
 #define REG_NAME          0x10 // R/W max 16chars
-#define REG_ON_TIME_HRS   0x20 // R/W
+#define REG_ON_TIME_HRS   0x20 // R/W  on time rounded to minutes
 #define REG_ON_TIME_MINS  0x21 // R/W  HRS==0 && MINS==0 > no timer
 #define REG_ACT_TIME_HRS  0x22 // R
 #define REG_ACT_TIME_MINS 0x23 // R
 #define REG_INVERT        0x24 // R/W  1 = invert
+#define REG_ON_TIME_MSB   0x25 // R/W  on time in seconds, 0 = no timer
+#define REG_ON_TIME_LSB   0x26 // R/W
+#define REG_REMAINING_MSB 0x27 // R    seconds left before the timer expires
+#define REG_REMAINING_LSB 0x28 // R
+#define REG_LEVEL         0x29 // R/W  level when on, 1..255
+#define REG_DIM           0x2A // R/W  1 = dimmed output (PWM)
 
-void swali_output_initialize(uint8_t swali_channel, swali_output_config_t * config, swali_output_data_t * data)
+void swali_output_initialize(uint8_t swali_channel, swali_output_config_t * config,
+                             uint8_t * level, swali_output_data_t * data)
 {
     data->swali_channel = swali_channel;
     data->config = config;
+    data->level = level;
     data->state = 0;
     data->last_state = 0;
-    data->last_time_ms = time_get_ms();
+    data->on_since = time_get_s();
     data->flash_timer = 0;
-    data->on_time_hrs = 0;
-    data->on_time_mins = 0;
+    data->dim = 0;
+    data->ramp_ms = time_get_ms();
+    // a configuration without a stored level starts at full
+    if (*data->level == 0)
+        *data->level = 255;
+    data->last_level = *data->level;
     update_output(data);
 }
 
 void swali_output_process(swali_output_data_t * data)
 {
-    uint16_t current_time = time_get_ms();
-
     // channel not enabled? Return!
     if (!(data->config->flags & FLAG_ENABLE))
     {
         return;
     }
 
-    // process the actual on timers
-    if (data->state)
-    {
-        if ((current_time - data->last_time_ms) > 60000)
-        {
-            //minute has elapsed
-            data->on_time_mins++;
-            if (data->on_time_mins == 60)
-            {
-                data->on_time_hrs++;
-                data->on_time_mins = 0;
-            }
-            data->last_time_ms = current_time;
-        }
-    }
-    else
+    // (re)start the timer when switched on, this includes a TURNON received
+    // while already on, which makes staircase lights retrigger
+    if (data->state && !data->last_state)
     {
-        data->last_time_ms = current_time;
-        data->on_time_hrs = 0;
-        data->on_time_mins = 0;
+        data->on_since = time_get_s();
+        if (data->config->on_time)
+            swali_timer_start(data->swali_channel, data->config->on_time);
     }
-
-    /* timer expired, send an event to turn off all outputs */
-    if (timer_on(data) &&
-            (data->on_time_hrs == data->config->on_time_hrs) &&
-            (data->on_time_mins == data->config->on_time_mins))
+    else if (!data->state && data->last_state)
     {
-        send_control_event(data);
+        swali_timer_stop(data->swali_channel);
     }
 
     // internal state changed (incoming event/timer), 
-    // send an information event
+    // send an information event unless the node coalesces them
     if (data->last_state != data->state)
     {
-        send_info_event(data);
+        if (!swali_coalesce_state(data->swali_channel))
+            send_info_event(data);
     }
+    else if ((data->last_level != *data->level) && data->state &&
+            (data->config->flags & FLAG_DIM))
+    {
+        send_level_event(data);
+    }
+    data->last_level = *data->level;
 
     update_output(data);
     data->last_state = data->state;
@@ -135,6 +144,20 @@ void swali_output_handle_event(swali_output_data_t * data, vscp_event_t * event)
                 data->last_state = 0;
             }
         }
+        if (event->vscp_type == VSCP_TYPE_CONTROL_CHANGE_LEVEL)
+        {
+            set_level(data, event->data[0]);
+        }
+        if (event->vscp_type == VSCP_TYPE_CONTROL_DIM_LAMPS)
+        {
+            // 0 = off, 1..100 = percentage, 254 = dim down, 255 = dim up
+            if (event->data[0] <= 100)
+                set_level(data, (uint16_t) event->data[0] * 255 / 100);
+            else if (event->data[0] == 254)
+                set_level(data, (*data->level > DIM_STEP) ? *data->level - DIM_STEP : 1);
+            else if (event->data[0] == 255)
+                set_level(data, (*data->level < 255 - DIM_STEP) ? *data->level + DIM_STEP : 255);
+        }
     }
 }
 
@@ -158,10 +181,25 @@ void swali_output_write_reg(swali_output_data_t * data, uint8_t reg, uint8_t val
         write_flag(data, FLAG_INVERT, value);
         break;
     case REG_ON_TIME_HRS:
-        data->config->on_time_hrs = value;
+        set_on_time(data, (uint32_t) value * 3600 +
+                    (data->config->on_time % 3600) / 60 * 60);
         break;
     case REG_ON_TIME_MINS:
-        data->config->on_time_mins = value;
+        set_on_time(data, data->config->on_time / 3600 * 3600 +
+                    (uint32_t) value * 60);
+        break;
+    case REG_ON_TIME_MSB:
+        data->config->on_time = (data->config->on_time & 0x00FF) | ((uint16_t) value << 8);
+        break;
+    case REG_ON_TIME_LSB:
+        data->config->on_time = (data->config->on_time & 0xFF00) | value;
+        break;
+    case REG_LEVEL:
+        if (value)
+            *data->level = value;
+        break;
+    case REG_DIM:
+        write_flag(data, FLAG_DIM, value);
         break;
     case REG_NAME:
         if (((reg - REG_NAME) < SWALI_NAME_LENGTH) && ((reg - REG_NAME) < 16))
@@ -203,16 +241,34 @@ uint8_t swali_output_read_reg(swali_output_data_t * data, uint8_t reg)
         value = read_flag(data, FLAG_INVERT);
         break;
     case REG_ON_TIME_HRS:
-        value = data->config->on_time_hrs;
+        value = data->config->on_time / 3600;
         break;
     case REG_ON_TIME_MINS:
-        value = data->config->on_time_mins;
+        value = (data->config->on_time % 3600) / 60;
         break;
     case REG_ACT_TIME_HRS:
-        value = data->on_time_hrs;
+        value = elapsed(data) / 3600;
         break;
     case REG_ACT_TIME_MINS:
-        value = data->on_time_mins;
+        value = (elapsed(data) % 3600) / 60;
+        break;
+    case REG_ON_TIME_MSB:
+        value = data->config->on_time >> 8;
+        break;
+    case REG_ON_TIME_LSB:
+        value = data->config->on_time & 0xFF;
+        break;
+    case REG_REMAINING_MSB:
+        value = swali_timer_remaining(data->swali_channel) >> 8;
+        break;
+    case REG_REMAINING_LSB:
+        value = swali_timer_remaining(data->swali_channel) & 0xFF;
+        break;
+    case REG_LEVEL:
+        value = *data->level;
+        break;
+    case REG_DIM:
+        value = read_flag(data, FLAG_DIM);
         break;
     case REG_NAME:
         if (((reg - REG_NAME) < SWALI_NAME_LENGTH) && ((reg - REG_NAME) < 16))
@@ -222,6 +278,51 @@ uint8_t swali_output_read_reg(swali_output_data_t * data, uint8_t reg)
     return value;
 }
 
+// drive the output to an exact state (0 = off, 1 = on, 2/3 = flashing)
+void swali_output_set_state(swali_output_data_t * data, uint8_t state)
+{
+    if (!(data->config->flags & FLAG_ENABLE))
+        return;
+
+    if (data->state != state)
+    {
+        data->state = state;
+    }
+    else
+    {
+        // already there, make sure an info update goes out anyway
+        data->last_state = state ? 0 : 1;
+    }
+}
+
+uint8_t swali_output_state(swali_output_data_t * data)
+{
+    return data->state;
+}
+
+void swali_output_report_state(swali_output_data_t * data)
+{
+    send_info_event(data);
+}
+
+/* timer expired, send an event to turn off all outputs in the zone */
+void swali_output_timer_expired(swali_output_data_t * data)
+{
+    if ((data->config->flags & FLAG_ENABLE) && data->state)
+        send_control_event(data);
+}
+
+void swali_output_upgrade_config(swali_output_config_t * config)
+{
+    // layout 0 held hours, minutes in the bytes now taken by on_time
+    uint8_t * on_time = (uint8_t *) &config->on_time;
+    uint32_t seconds = (uint32_t) on_time[0] * 3600 + (uint32_t) on_time[1] * 60;
+
+    if (seconds > 0xFFFF)
+        seconds = 0xFFFF;
+    config->on_time = (uint16_t) seconds;
+}
+
 static void send_control_event(swali_output_data_t * data)
 {
     vscp_event_t tx_event;
@@ -256,9 +357,25 @@ static void send_info_event(swali_output_data_t * data)
     swali_send_event(&tx_event);
 }
 
+static void send_level_event(swali_output_data_t * data)
+{
+    vscp_event_t tx_event;
+
+    tx_event.priority = VSCP_PRIORITY_MEDIUM;
+    tx_event.vscp_class = VSCP_CLASS1_INFORMATION;
+    tx_event.vscp_type = VSCP_TYPE_INFORMATION_LEVEL_CHANGED;
+    tx_event.size = 3;
+    tx_event.data[0] = *data->level;
+    tx_event.data[1] = data->config->zone;
+    tx_event.data[2] = data->config->subzone;
+
+    swali_send_event(&tx_event);
+}
+
 static void update_output(swali_output_data_t * data)
 {
     uint8_t pin_value;
+    uint8_t level;
     uint16_t now;
     
     now = time_get_ms();
@@ -272,12 +389,63 @@ static void update_output(swali_output_data_t * data)
                 
     if(data->state == 3)
         pin_value = ((now - data->flash_timer) % 4096) < 2048;
-                
+
+    if (data->config->flags & FLAG_DIM)
+    {
+        ramp(data, pin_value ? *data->level : 0);
+        level = data->dim >> 8;
+        if (data->config->flags & FLAG_INVERT)
+            level = 255 - level;
+        pwm_set(data->swali_channel, level);
+        return;
+    }
+    pwm_release(data->swali_channel);
+
     if (data->config->flags & FLAG_INVERT)
         pin_value = !pin_value;
     discrete_write(data->swali_channel, pin_value);
 }
 
+/* move the actual level towards target, a full sweep takes the ramp time
+ * of the node (x100ms)
+ */
+static void ramp(swali_output_data_t * data, uint8_t target)
+{
+    uint16_t goal = (uint16_t) target << 8;
+    uint16_t ticks = (uint16_t) (time_get_ms() - data->ramp_ms) / 10;
+    uint8_t ramp_time = swali_ramp_time();
+    uint32_t step;
+
+    data->ramp_ms += ticks * 10;
+
+    if (ramp_time == 0)
+    {
+        data->dim = goal;
+        return;
+    }
+    if ((ticks == 0) || (data->dim == goal))
+        return;
+
+    step = (uint32_t) ticks * 0xFF00 / ((uint16_t) ramp_time * 10);
+    if (data->dim < goal)
+        data->dim = ((uint16_t) (goal - data->dim) > step) ? data->dim + (uint16_t) step : goal;
+    else
+        data->dim = ((uint16_t) (data->dim - goal) > step) ? data->dim - (uint16_t) step : goal;
+}
+
+// level 0 turns the output off, any other level turns it on at that level
+static void set_level(swali_output_data_t * data, uint8_t level)
+{
+    if (level == 0)
+    {
+        data->state = 0;
+        return;
+    }
+    *data->level = level;
+    if (data->state == 0)
+        data->state = 1;
+}
+
 static void write_flag(swali_output_data_t * data, uint8_t flag, uint8_t value)
 {
     if (value == 0)
@@ -305,7 +473,16 @@ static uint8_t reg_range(uint8_t reg)
     return value;
 }
 
-static uint8_t timer_on(swali_output_data_t * data)
+static uint32_t elapsed(swali_output_data_t * data)
+{
+    if (!data->state)
+        return 0;
+    return time_get_s() - data->on_since;
+}
+
+static void set_on_time(swali_output_data_t * data, uint32_t seconds)
 {
-    return ((data->config->on_time_hrs > 0) || (data->config->on_time_mins > 0));
+    if (seconds > 0xFFFF)
+        seconds = 0xFFFF;
+    data->config->on_time = (uint16_t) seconds;
 }
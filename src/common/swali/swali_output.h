@@ -29,27 +29,35 @@ extern "C" {
         uint8_t flags;
         uint8_t zone;
         uint8_t subzone;
-        uint8_t on_time_hrs;
-        uint8_t on_time_mins;
+        uint16_t on_time; // seconds, 0 = no timer
         char name [SWALI_NAME_LENGTH];
     } swali_output_config_t;
 
     typedef struct {
-        uint16_t last_time_ms;
+        uint32_t on_since; // seconds
         uint16_t flash_timer;
+        uint16_t dim;      // actual level while ramping, 8.8 fixed point
+        uint16_t ramp_ms;
+        uint8_t * level;   // level when on for dimmed outputs, in the config
+        uint8_t last_level;
         uint8_t swali_channel;
         uint8_t state;
         uint8_t last_state;
-        uint8_t on_time_hrs;
-        uint8_t on_time_mins;
         swali_output_config_t * config;
     } swali_output_data_t;
 
-    void swali_output_initialize(uint8_t swali_channel, swali_output_config_t * config, swali_output_data_t * data);
+    void swali_output_initialize(uint8_t swali_channel, swali_output_config_t * config,
+                                 uint8_t * level, swali_output_data_t * data);
     void swali_output_process(swali_output_data_t * data);
     void swali_output_handle_event(swali_output_data_t * data, vscp_event_t * event);
     void swali_output_write_reg(swali_output_data_t * data, uint8_t reg, uint8_t value);
     uint8_t swali_output_read_reg(swali_output_data_t * data, uint8_t reg);
+    uint8_t swali_output_state(swali_output_data_t * data);
+    void swali_output_report_state(swali_output_data_t * data);
+    void swali_output_set_state(swali_output_data_t * data, uint8_t state);
+    void swali_output_timer_expired(swali_output_data_t * data);
+    // convert a configuration stored by a firmware using layout 0
+    void swali_output_upgrade_config(swali_output_config_t * config);
 
 
 #ifdef	__cplusplus
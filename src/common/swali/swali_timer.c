@@ -0,0 +1,99 @@
+/* 
+ * This file is part of Swali VSCP, https://www.github.com/swali_vscp.
+ * Copyright (c) 2020 Maarten Zanders.
+ * 
+ * This program is free software: you can redistribute it and/or modify  
+ * it under the terms of the GNU General Public License as published by  
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but 
+ * WITHOUT ANY WARRANTY; without even the implied warranty of 
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU 
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License 
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "swali_config.h"
+#include "swali_timer.h"
+#include "time.h"
+
+#define NUM_TIMERS (SWALI_NUM_INPUTS + SWALI_NUM_OUTPUTS)
+
+static uint32_t deadline[NUM_TIMERS];
+static uint8_t next[NUM_TIMERS];
+static uint8_t head = SWALI_TIMER_NONE;
+static uint16_t running; // one bit per timer
+
+static void unlink(uint8_t id);
+
+void swali_timer_start(uint8_t id, uint16_t seconds)
+{
+    uint8_t * link;
+
+    swali_timer_stop(id);
+
+    // a started second is not counted, so never expire early
+    deadline[id] = time_get_s() + seconds + 1;
+
+    link = &head;
+    while ((*link != SWALI_TIMER_NONE) &&
+            ((int32_t) (deadline[*link] - deadline[id]) <= 0))
+    {
+        link = &next[*link];
+    }
+    next[id] = *link;
+    *link = id;
+    running |= (uint16_t) 1 << id;
+}
+
+void swali_timer_stop(uint8_t id)
+{
+    if (running & ((uint16_t) 1 << id))
+    {
+        unlink(id);
+        running &= ~((uint16_t) 1 << id);
+    }
+}
+
+uint16_t swali_timer_remaining(uint8_t id)
+{
+    int32_t remaining;
+
+    if (!(running & ((uint16_t) 1 << id)))
+        return 0;
+
+    remaining = (int32_t) (deadline[id] - time_get_s()) - 1;
+    if (remaining < 0)
+        remaining = 0;
+    return (uint16_t) remaining;
+}
+
+uint8_t swali_timer_expired(void)
+{
+    uint8_t id = head;
+
+    if ((id == SWALI_TIMER_NONE) ||
+            ((int32_t) (time_get_s() - deadline[id]) < 0))
+        return SWALI_TIMER_NONE;
+
+    head = next[id];
+    running &= ~((uint16_t) 1 << id);
+    return id;
+}
+
+static void unlink(uint8_t id)
+{
+    uint8_t * link = &head;
+
+    while (*link != SWALI_TIMER_NONE)
+    {
+        if (*link == id)
+        {
+            *link = next[id];
+            return;
+        }
+        link = &next[*link];
+    }
+}
@@ -0,0 +1,43 @@
+/* 
+ * This file is part of Swali VSCP, https://www.github.com/swali_vscp.
+ * Copyright (c) 2020 Maarten Zanders.
+ * 
+ * This program is free software: you can redistribute it and/or modify  
+ * it under the terms of the GNU General Public License as published by  
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but 
+ * WITHOUT ANY WARRANTY; without even the implied warranty of 
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU 
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License 
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _SWALI_TIMER_H_
+#define	_SWALI_TIMER_H_
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define SWALI_TIMER_NONE 0xFF
+
+    /* Second resolution timers shared by all channels, identified by their
+     * swali channel. Running timers are kept sorted on their deadline, so
+     * only the first one is checked when looking for expired timers.
+     */
+    void swali_timer_start(uint8_t id, uint16_t seconds);
+    void swali_timer_stop(uint8_t id);
+    uint16_t swali_timer_remaining(uint8_t id);
+    // returns an expired timer (and stops it) or SWALI_TIMER_NONE
+    uint8_t swali_timer_expired(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _SWALI_TIMER_H_ */
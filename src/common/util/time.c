@@ -18,8 +18,14 @@
 #include "time.h"
 #include "systick.h"
 
+typedef struct
+{
+    uint16_t ms;
+    uint32_t s;
+} time_stamp_t;
+
 /* Double buffer holding the value to be read */
-static uint16_t current_time [2];
+static time_stamp_t current_time [2];
 
 /* "get_time is going to read from here" */
 static uint8_t read_pointer; 
@@ -30,6 +36,8 @@ static uint8_t write_pointer;
 void time_update(void)
 {
     static unsigned uint16_t counter = 0;
+    static uint16_t ms_in_second = 0;
+    static uint32_t seconds = 0;
     uint8_t new_write_pointer = write_pointer;
 
     if (read_pointer == write_pointer)
@@ -37,14 +45,24 @@ void time_update(void)
         new_write_pointer = (read_pointer + 1) % 2;
     }
 
-    current_time [new_write_pointer] = ++counter;
+    // counted here rather than derived from the ms counter: no drift
+    if (++ms_in_second == 1000)
+    {
+        ms_in_second = 0;
+        seconds++;
+    }
+
+    current_time [new_write_pointer].ms = ++counter;
+    current_time [new_write_pointer].s = seconds;
     write_pointer = new_write_pointer;
 }
 
 void time_init(void)
 {
-    current_time[0] = 0;
-    current_time[1] = 0;
+    current_time[0].ms = 0;
+    current_time[0].s = 0;
+    current_time[1].ms = 0;
+    current_time[1].s = 0;
     read_pointer = 0;
     write_pointer = 0;
 
@@ -54,5 +72,11 @@ void time_init(void)
 uint16_t time_get_ms(void)
 {
     read_pointer = write_pointer;
-    return current_time[read_pointer];
+    return current_time[read_pointer].ms;
+}
+
+uint32_t time_get_s(void)
+{
+    read_pointer = write_pointer;
+    return current_time[read_pointer].s;
 }
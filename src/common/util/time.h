@@ -24,6 +24,7 @@ extern "C" {
 #endif
     void time_init(void);
     uint16_t time_get_ms(void);
+    uint32_t time_get_s(void); // seconds since time_init()
 
 #ifdef	__cplusplus
 }
@@ -35,8 +35,14 @@ static uint8_t vscp_state;
 static uint8_t nickname;
 
 /* init state variables & constants */
-/* timeout for probing an active device */
+/* timeout for probing an active device, the actual timeout adapts to the
+ * round trip time of the probe ACKs seen on the bus between these limits.
+ * The last retry before taking a nickname always waits the full timeout,
+ * the owner may be busy sending for a while before it answers.
+ */
 #define VSCP_PROBE_TIMEOUT 500
+#define VSCP_PROBE_TIMEOUT_MIN 100
+#define VSCP_PROBE_RTT_FACTOR 4
 /* timeout for a master to come and give us an address */
 #define VSCP_MASTER_TIMEOUT 5000
 /* nickname currently in use for probing */
@@ -45,6 +51,16 @@ static uint8_t probe_nickname;
 static uint16_t probe_start_time;
 #define NUM_PROBE_RETRIES 3
 static uint8_t probe_retry_count;
+static uint16_t probe_timeout;
+/* candidates after the master: nicknames 1..VSCP_NICKNAME_MAX in a GUID-seeded order
+ * so nodes starting together don't all probe the same addresses. A power-up
+ * resumes the stored nickname without probing. After DROP_NICKNAME or the
+ * init button the node gives it up, so it is skipped.
+ */
+static uint8_t probe_skip;
+static uint8_t probe_count;
+static uint8_t probe_hash;
+static uint8_t probe_step;
 
 typedef enum
 {
@@ -53,12 +69,71 @@ typedef enum
 init_state_t init_state;
 
 /* active state variables & constants */
-/* time in ms between node heartbeats */
-#define VSCP_HEARTBEAT_PERIOD 60000
-static uint16_t last_heartbeat;
+/* time in s between node heartbeats, configurable on the VSCP node page.
+ * Heartbeats stay at a per node phase in the period.
+ */
+#define VSCP_HEARTBEAT_PERIOD 60
+static uint32_t last_heartbeat;
+static uint8_t heartbeat_period;
+
+/* When the power returns all nodes become active at the same time. The
+ * bring-up is done in phases, each spread by a GUID derived jitter:
+ * announce (NEW_NODE_ONLINE), then the application publishes its state and
+ * the first heartbeat lands somewhere in the heartbeat period. Events sent
+ * before the announce wait in the TX queue.
+ */
+#define VSCP_STARTUP_JITTER 1024 // ms, power of 2
+#define VSCP_STARTUP_STATE 1000 // ms after the announce
+#define VSCP_STARTUP_HEARTBEAT 3 // s, earliest first heartbeat
+
+typedef enum
+{
+    startup_announce, startup_state, startup_done
+} startup_phase_t;
+static startup_phase_t startup_phase;
+static uint16_t startup_start;
+static uint16_t startup_delay;
 static uint16_t vscp_current_page;
 static uint8_t vscp_error_counter;
 
+/* While the controller is error-passive, non-critical events (everything
+ * except protocol and control events) go through the TX queue with an
+ * exponential back-off between them. A node with bus trouble then doesn't
+ * add to the retransmissions of everyone else. In bus-off nothing is sent.
+ */
+#define VSCP_BACKOFF_MIN 10 // ms
+#define VSCP_BACKOFF_MAX 2560 // ms
+static uint16_t tx_backoff; // 0 = error-active, no back-off
+static uint16_t tx_backoff_start;
+
+/* diagnostics on VSCP_NODE_PAGE, see vscp_get_reg_node_value() */
+static uint16_t tx_retries; // events which didn't get a TX buffer right away
+static uint16_t loop_last;
+static uint16_t loop_max; // longest time between two vscp_process() calls
+#define VSCP_DIAG_SIZE 19
+static uint8_t diag[VSCP_DIAG_SIZE];
+
+/* Events which don't need to go out right away are paced through a queue,
+ * one frame per pass when the CAN layer accepts it.
+ */
+#define VSCP_TX_QUEUE_SIZE 8
+#define VSCP_TX_TIMEOUT 1000
+static vscp_event_t tx_queue[VSCP_TX_QUEUE_SIZE];
+static uint8_t tx_queue_head;
+static uint8_t tx_queue_count;
+static uint16_t tx_queue_start;
+static uint8_t tx_queue_retry;
+
+/* WHO_IS_THERE responses (7 frames) are generated into the TX queue one by
+ * one. A broadcast request is answered in a time slot per nickname, so the
+ * nodes don't all respond at once.
+ */
+#define WHO_IS_THERE_FRAMES 7
+#define WHO_IS_THERE_SLOT 8 // ms per nickname, 7 frames take ~7.5ms @ 125k
+static uint8_t who_is_there_frame;
+static uint16_t who_is_there_start;
+static uint16_t who_is_there_delay;
+
 /* Private functions */
 /* change the state to the indicated value. This calls the preparation of the
  state handler and notifies the user application through a message */
@@ -77,6 +152,16 @@ static void vscp_send_event(vscp_event_t * event);
 static int vscp_receive_event(vscp_event_t * event);
 static void vscp_process_protocol_event(vscp_event_t * event);
 static void vscp_send_protocol_event(uint8_t type, uint8_t length, uint8_t data[]);
+static void vscp_next_probe_nickname(void);
+static uint16_t vscp_guid_hash(void);
+static void vscp_process_startup(void);
+static void vscp_send_heartbeat(void);
+static uint8_t vscp_queue_event(vscp_event_t * event);
+static void vscp_process_tx_queue(void);
+static uint8_t vscp_critical_event(vscp_event_t * event);
+static uint8_t vscp_tx_priority(vscp_event_t * event);
+static void vscp_count_error(void);
+static void vscp_process_who_is_there(void);
 
 static uint8_t vscp_get_reg_value(uint8_t reg, uint16_t page);
 static void vscp_set_reg_value(uint8_t reg, uint16_t page, uint8_t value);
@@ -85,6 +170,9 @@ static void vscp_set_reg_std_value(uint8_t reg, uint8_t value);
 static uint8_t vscp_get_reg_msg_value(uint8_t reg, uint16_t page);
 static void vscp_set_reg_msg_value(uint8_t reg, uint16_t page, uint8_t value);
 static uint8_t vscp_std_reg_range(uint8_t reg);
+static uint8_t vscp_get_reg_node_value(uint8_t reg);
+static void vscp_set_reg_node_value(uint8_t reg, uint8_t value);
+static void vscp_diag_snapshot(void);
 
 /* vscp state prepare & handlers */
 static void vscp_prepare_startup_state();
@@ -105,6 +193,7 @@ void vscp_init(void message_callback(vscp_message_t * message),
     message_callback_ = message_callback;
     event_callback_ = event_callback;
     vscp_error_counter = 0;
+    loop_last = time_get_ms();
 
     // set the internal state, initialize vscp_state
     vscp_set_state(VSCP_STATE_STARTUP);
@@ -115,16 +204,42 @@ void vscp_send(vscp_event_t * event)
 {
     // User is not allowed to send protocol events
     // don't send anything when we're not in the active state
-    if ((event->vscp_class != VSCP_CLASS1_PROTOCOL) &&
-            (vscp_state == VSCP_STATE_ACTIVE))
+    if ((event->vscp_class == VSCP_CLASS1_PROTOCOL) ||
+            (vscp_state != VSCP_STATE_ACTIVE))
+        return;
+
+    // queued until we've announced ourselves
+    if (startup_phase == startup_announce)
+    {
+        if (!vscp_queue_event(event))
+            vscp_count_error();
+    }
+    else
         vscp_send_event(event);
 }
 
+uint8_t vscp_get_nickname(void)
+{
+    return nickname;
+}
+
 // State processing & manipulation
 // -------------------------------
 
 void vscp_process(uint8_t init)
 {
+    uint16_t loop_time = time_get_ms() - loop_last;
+
+    loop_last += loop_time;
+    if (loop_time > loop_max)
+        loop_max = loop_time;
+
+    can_process();
+    if (can_error_state() == CAN_ERROR_ACTIVE)
+        tx_backoff = 0;
+    else if (tx_backoff == 0)
+        tx_backoff = VSCP_BACKOFF_MIN;
+
     if (init && (vscp_state != VSCP_STATE_INIT))
     {
         vscp_set_state(VSCP_STATE_INIT);
@@ -195,12 +310,40 @@ static void vscp_handle_startup_state()
 
 static void vscp_prepare_init_state()
 {
+    uint16_t hash = vscp_guid_hash();
+
+    // vscp_state is still the state we come from
+    if ((vscp_state == VSCP_STATE_STARTUP) ||
+            !vscp_get_msg_value(VSCP_MSG_NICKNAME, 0, &probe_skip))
+        probe_skip = VSCP_NICKNAME_FREE;
+
+    // 127 candidates is a prime, so any step 1..126 visits them all
+    probe_hash = (uint8_t) hash;
+    probe_step = 1 + (uint8_t) ((hash >> 8) % (VSCP_NICKNAME_MAX - 1));
+    probe_count = 0;
+
     nickname = VSCP_NICKNAME_FREE;
     probe_nickname = VSCP_NICKNAME_MASTER;
+    probe_timeout = VSCP_PROBE_TIMEOUT_MIN;
     init_state = send_probe;
     probe_retry_count = 0;
 }
 
+static void vscp_next_probe_nickname(void)
+{
+    do
+    {
+        if (probe_count == VSCP_NICKNAME_MAX)
+        {
+            probe_nickname = VSCP_NICKNAME_FREE;
+            return;
+        }
+        probe_nickname = 1 + (uint8_t) ((probe_hash + (uint16_t) probe_count * probe_step) % VSCP_NICKNAME_MAX);
+        probe_count++;
+    }
+    while (probe_nickname == probe_skip);
+}
+
 static void vscp_handle_init_state()
 {
     vscp_event_t rxevent;
@@ -226,7 +369,8 @@ static void vscp_handle_init_state()
 
     case wait_for_ack:
         // check for timeout first
-        if ((time_get_ms() - probe_start_time) > VSCP_PROBE_TIMEOUT)
+        if ((time_get_ms() - probe_start_time) >
+                ((probe_retry_count == NUM_PROBE_RETRIES - 1) ? VSCP_PROBE_TIMEOUT : probe_timeout))
         {
             if (probe_retry_count == NUM_PROBE_RETRIES - 1)
             {
@@ -234,7 +378,7 @@ static void vscp_handle_init_state()
                 if (probe_nickname == VSCP_NICKNAME_MASTER)
                 {
                     // No master present, move on to the next one
-                    probe_nickname++;
+                    vscp_next_probe_nickname();
                     init_state = send_probe;
                 }
                 else
@@ -260,6 +404,14 @@ static void vscp_handle_init_state()
                         (rxevent.size == 0) &&
                         (rxevent.nickname == probe_nickname))
                 {
+                    uint16_t rtt = (time_get_ms() - probe_start_time) * VSCP_PROBE_RTT_FACTOR;
+
+                    if (rtt > VSCP_PROBE_TIMEOUT)
+                        rtt = VSCP_PROBE_TIMEOUT;
+                    if (rtt > probe_timeout)
+                        probe_timeout = rtt;
+
+                    probe_retry_count = 0;
                     if (probe_nickname == VSCP_NICKNAME_MASTER)
                     {
                         // there is a master on the bus, let's wait for him
@@ -270,7 +422,7 @@ static void vscp_handle_init_state()
                     else
                     {
                         // someone has taken this address already, move on
-                        probe_nickname++;
+                        vscp_next_probe_nickname();
                         init_state = send_probe;
                     }
                 }
@@ -283,7 +435,7 @@ static void vscp_handle_init_state()
         if ((time_get_ms() - probe_start_time) > VSCP_MASTER_TIMEOUT)
         {
             // Master hasn't come to give us an address, continue auto-discovery
-            probe_nickname++;
+            vscp_next_probe_nickname();
             init_state = send_probe;
         }
         else
@@ -311,31 +463,47 @@ static void vscp_handle_init_state()
 
 static void vscp_prepare_active_state()
 {
-    /* Let everyone know we're here */
-    vscp_send_protocol_event(VSCP_TYPE_PROTOCOL_NEW_NODE_ONLINE, 1, &nickname);
-    last_heartbeat = time_get_ms();
+    uint16_t hash = vscp_guid_hash();
+
+    /* Let everyone know we're here, after a random delay */
+    startup_phase = startup_announce;
+    startup_start = time_get_ms();
+    startup_delay = hash & (VSCP_STARTUP_JITTER - 1);
+
+    // first heartbeat at a random time in the period, not before
+    // VSCP_STARTUP_HEARTBEAT. A period that short gets a full one.
+    if (!vscp_get_msg_value(VSCP_MSG_HEARTBEAT, 0, &heartbeat_period) ||
+            (heartbeat_period == 0))
+        heartbeat_period = VSCP_HEARTBEAT_PERIOD;
+    last_heartbeat = time_get_s();
+    if (heartbeat_period > VSCP_STARTUP_HEARTBEAT)
+        last_heartbeat += VSCP_STARTUP_HEARTBEAT - heartbeat_period +
+            (hash % (heartbeat_period - VSCP_STARTUP_HEARTBEAT));
     vscp_current_page = 0;
+    tx_queue_count = 0;
+    who_is_there_frame = WHO_IS_THERE_FRAMES;
 }
 
 static void vscp_handle_active_state()
 {
-    vscp_event_t tx_event;
     vscp_event_t rx_event;
 
+    vscp_process_startup();
+
     /* Send a periodic heartbeat */
-    if ((time_get_ms() - last_heartbeat) > VSCP_HEARTBEAT_PERIOD)
+    if ((time_get_s() - last_heartbeat) >= heartbeat_period)
     {
-        tx_event.priority = VSCP_PRIORITY_LOW;
-        tx_event.vscp_class = VSCP_CLASS1_INFORMATION;
-        tx_event.vscp_type = VSCP_TYPE_INFORMATION_NODE_HEARTBEAT;
-        tx_event.size = 3;
-        tx_event.data[0] = 0;
-        tx_event.data[1] = 0;
-        tx_event.data[2] = 0;
-        vscp_send_event(&tx_event);
-        last_heartbeat = time_get_ms();
+        vscp_send_heartbeat();
+
+        // keep the phase, unless we've fallen behind a full period
+        last_heartbeat += heartbeat_period;
+        if ((time_get_s() - last_heartbeat) >= heartbeat_period)
+            last_heartbeat = time_get_s();
     }
 
+    vscp_process_who_is_there();
+    vscp_process_tx_queue();
+
     if (vscp_receive_event(&rx_event))
     {
         if (rx_event.vscp_class == VSCP_CLASS1_PROTOCOL)
@@ -370,6 +538,7 @@ static void vscp_send_event(vscp_event_t * event)
     uint16_t start_time;
     uint8_t error = 1;
 
+    event->nickname = nickname;
     id = ((uint32_t) event->priority << 26) |
             ((uint32_t) event->vscp_class << 16) |
             ((uint32_t) event->vscp_type << 8) |
@@ -377,22 +546,66 @@ static void vscp_send_event(vscp_event_t * event)
 
     start_time = time_get_ms();
 
+    if (can_error_state() == CAN_BUS_OFF)
+    {
+        vscp_count_error();
+        return;
+    }
+
+    if (tx_backoff && !vscp_critical_event(event))
+    {
+        if (!vscp_queue_event(event))
+            vscp_count_error();
+        return;
+    }
+
+    if (can_send_extended(id, event->data, event->size, vscp_tx_priority(event)))
+        return;
+    tx_retries++;
+
     // try for one second
     while ((time_get_ms() - start_time) < 1000)
     {
-        if (can_send_extended(id, event->data, event->size))
+        if (can_send_extended(id, event->data, event->size, vscp_tx_priority(event)))
         {
             error = 0;
             break;
         }
+        can_process();
+        if (can_error_state() == CAN_BUS_OFF)
+            break;
     }
 
     if (error)
-    {
-        vscp_error_counter++;
-        if (vscp_error_counter == 0)
-            vscp_error_counter--;
-    }
+        vscp_count_error();
+}
+
+static uint8_t vscp_critical_event(vscp_event_t * event)
+{
+    return (event->vscp_class == VSCP_CLASS1_PROTOCOL) ||
+            (event->vscp_class == VSCP_CLASS1_CONTROL);
+}
+
+/* Control events (switching lights, ...) are urgent: they're sent first and
+ * may take the TX buffer that's kept free. Everything else gets a transmit
+ * priority following its VSCP priority.
+ */
+static uint8_t vscp_tx_priority(vscp_event_t * event)
+{
+    if (event->vscp_class == VSCP_CLASS1_CONTROL)
+        return CAN_TX_PRIORITY_HIGHEST | CAN_TX_URGENT;
+    if (event->priority < VSCP_PRIORITY_MEDIUM)
+        return CAN_TX_PRIORITY_HIGH;
+    if (event->priority < VSCP_PRIORITY_LOW)
+        return CAN_TX_PRIORITY_MEDIUM;
+    return CAN_TX_PRIORITY_LOW;
+}
+
+static void vscp_count_error(void)
+{
+    vscp_error_counter++;
+    if (vscp_error_counter == 0)
+        vscp_error_counter--;
 }
 
 static int vscp_receive_event(vscp_event_t * event)
@@ -469,7 +682,7 @@ static void vscp_process_protocol_event(vscp_event_t * event)
     case VSCP_TYPE_PROTOCOL_ENTER_BOOT_LOADER:
         if ((event->size == 8) && (event->data[0] == nickname))
         {
-            uint8_t algorithm;
+            uint8_t algorithm = VSCP_BOOTLOADER_NONE;
             if (vscp_get_msg_value(VSCP_MSG_BOOT_ALG, 0, &algorithm))
             {
                 // the application supports bootloader
@@ -525,47 +738,13 @@ static void vscp_process_protocol_event(vscp_event_t * event)
     case VSCP_TYPE_PROTOCOL_WHO_IS_THERE:
         if ((event->size == 1) && ((event->data[0] == nickname) || (event->data[0] == 0xFF)))
         {
-            // routine taken from original vscp_firmware file.
-            uint8_t i, j, k;
-            uint8_t data[8];
-
-            k = 0;
-            for (i = 0; i < 3; i++) // fill up with GUID
-            {
-                data[0] = i;
-                
-                for (j = 1; j < 8; j++)
-                {
-                    data[j] = vscp_guid(15 - k++);
-                    if (k >= 16)
-                        break;
-                }
-                if (k >= 16)
-                    break;
-                vscp_send_protocol_event(VSCP_TYPE_PROTOCOL_WHO_IS_THERE_RESPONSE, 8, data);
-            }
-
-            for (j = 0; j < 5; j++) // fill up previous event with MDF
-            {
-                if (vscp_mdf(j) > 0)
-                    data[3 + j] = vscp_mdf(j);
-                else
-                    data[3 + j] = 0;
-            }
-
-            vscp_send_protocol_event(VSCP_TYPE_PROTOCOL_WHO_IS_THERE_RESPONSE, 8, data);
-
-            k = 5; // start offset
-            for (i = 3; i < 7; i++) // fill up with the rest of GUID
-            {
-                data[0] = i;
-
-                for (j = 1; j < 8; j++)
-                {
-                    data[j] = vscp_mdf(k++);
-                }
-                vscp_send_protocol_event(VSCP_TYPE_PROTOCOL_WHO_IS_THERE_RESPONSE, 8, data);
-            }
+            // the response itself goes out from vscp_process_who_is_there()
+            who_is_there_frame = 0;
+            who_is_there_start = time_get_ms();
+            if (event->data[0] == nickname)
+                who_is_there_delay = 0;
+            else
+                who_is_there_delay = (uint16_t) nickname * WHO_IS_THERE_SLOT;
         }
         break;
 
@@ -575,9 +754,10 @@ static void vscp_process_protocol_event(vscp_event_t * event)
             uint8_t data[4];
             for (uint8_t i = 0; i < 4; i++)
             {
+                data[i] = 0;
                 vscp_get_msg_value(VSCP_MSG_DMINFO, i, &data[i]);
             }
-            vscp_send_protocol_event(VSCP_TYPE_PROTOCOL_GET_EMBEDDED_MDF_RESPONSE, 4, data);
+            vscp_send_protocol_event(VSCP_TYPE_PROTOCOL_GET_MATRIX_INFO_RESPONSE, 4, data);
         }
         break;
 
@@ -704,6 +884,150 @@ static void vscp_send_protocol_event(uint8_t type, uint8_t length, uint8_t data[
     vscp_send_event(&tx_event);
 }
 
+static void vscp_process_startup(void)
+{
+    if ((startup_phase == startup_done) ||
+            ((uint16_t) (time_get_ms() - startup_start) < startup_delay))
+        return;
+
+    switch (startup_phase)
+    {
+    case startup_announce:
+        vscp_send_protocol_event(VSCP_TYPE_PROTOCOL_NEW_NODE_ONLINE, 1, &nickname);
+        startup_phase = startup_state;
+        startup_start = time_get_ms();
+        startup_delay = VSCP_STARTUP_STATE;
+        break;
+
+    case startup_state:
+        vscp_set_msg_value(VSCP_MSG_PUBLISH_STATE, 0, 0);
+        startup_phase = startup_done;
+        break;
+
+    case startup_done:
+        break;
+    }
+}
+
+/* Heartbeat with the health of the node:
+ *   data[0..2] = 0 (user byte, zone, subzone)
+ *   data[3] = error counter (TX failures)
+ *   data[4] = CAN RX overflow count
+ *   data[5..6] = uptime in minutes, MSB first
+ *   data[7] = CRC-8 of the application configuration
+ */
+static void vscp_send_heartbeat(void)
+{
+    vscp_event_t tx_event;
+    uint16_t uptime = (uint16_t) (time_get_s() / 60);
+
+    tx_event.priority = VSCP_PRIORITY_LOW;
+    tx_event.vscp_class = VSCP_CLASS1_INFORMATION;
+    tx_event.vscp_type = VSCP_TYPE_INFORMATION_NODE_HEARTBEAT;
+    tx_event.size = 8;
+    tx_event.data[0] = 0;
+    tx_event.data[1] = 0;
+    tx_event.data[2] = 0;
+    tx_event.data[3] = vscp_error_counter;
+    tx_event.data[4] = can_get_stats()->rx_overflows;
+    tx_event.data[5] = (uint8_t) (uptime >> 8);
+    tx_event.data[6] = (uint8_t) uptime;
+    if (!vscp_get_msg_value(VSCP_MSG_CONFIG_CRC, 0, &tx_event.data[7]))
+        tx_event.data[7] = 0;
+    vscp_send_event(&tx_event);
+}
+
+static uint8_t vscp_queue_event(vscp_event_t * event)
+{
+    if (tx_queue_count == VSCP_TX_QUEUE_SIZE)
+        return 0;
+
+    tx_queue[(tx_queue_head + tx_queue_count) % VSCP_TX_QUEUE_SIZE] = *event;
+    if (tx_queue_count == 0)
+        tx_queue_start = time_get_ms();
+    tx_queue_count++;
+    return 1;
+}
+
+static void vscp_process_tx_queue(void)
+{
+    vscp_event_t * event;
+    uint32_t id;
+
+    if (tx_queue_count == 0)
+        return;
+
+    event = &tx_queue[tx_queue_head];
+    if ((can_error_state() == CAN_BUS_OFF) ||
+            (startup_phase == startup_announce))
+    {
+        tx_queue_start = time_get_ms();
+        return;
+    }
+    if (tx_backoff && !vscp_critical_event(event) &&
+            ((uint16_t) (time_get_ms() - tx_backoff_start) < tx_backoff))
+        return;
+
+    event->nickname = nickname;
+    id = ((uint32_t) event->priority << 26) |
+            ((uint32_t) event->vscp_class << 16) |
+            ((uint32_t) event->vscp_type << 8) |
+            nickname;
+
+    if (!can_send_extended(id, event->data, event->size, vscp_tx_priority(event)))
+    {
+        // no TX buffer available, try again next pass unless it's been
+        // stuck for too long
+        if (!tx_queue_retry)
+            tx_retries++;
+        tx_queue_retry = 1;
+        if ((uint16_t) (time_get_ms() - tx_queue_start) < VSCP_TX_TIMEOUT)
+            return;
+
+        vscp_count_error();
+    }
+    else if (tx_backoff && !vscp_critical_event(event))
+    {
+        // still error-passive, wait twice as long for the next one
+        tx_backoff_start = time_get_ms();
+        if (tx_backoff < VSCP_BACKOFF_MAX)
+            tx_backoff <<= 1;
+    }
+
+    tx_queue_head = (tx_queue_head + 1) % VSCP_TX_QUEUE_SIZE;
+    tx_queue_count--;
+    tx_queue_start = time_get_ms();
+    tx_queue_retry = 0;
+}
+
+/* The response is the GUID (MSB first) followed by the MDF URL, 7 bytes per
+ * frame, data[0] holds the frame index.
+ */
+static void vscp_process_who_is_there(void)
+{
+    uint8_t b;
+    vscp_event_t tx_event = {VSCP_PRIORITY_HIGH, VSCP_CLASS1_PROTOCOL,
+        VSCP_TYPE_PROTOCOL_WHO_IS_THERE_RESPONSE, 0, 8,
+        {0, 0, 0, 0, 0, 0, 0, 0}};
+
+    if ((who_is_there_frame == WHO_IS_THERE_FRAMES) ||
+            ((uint16_t) (time_get_ms() - who_is_there_start) < who_is_there_delay))
+        return;
+
+    tx_event.data[0] = who_is_there_frame;
+    b = who_is_there_frame * 7;
+    for (uint8_t j = 1; j < 8; j++, b++)
+    {
+        if (b < 16)
+            tx_event.data[j] = vscp_guid(15 - b);
+        else
+            tx_event.data[j] = vscp_mdf(b - 16);
+    }
+
+    if (vscp_queue_event(&tx_event))
+        who_is_there_frame++;
+}
+
 // Register manipulation
 // ---------------------
 
@@ -711,7 +1035,11 @@ static uint8_t vscp_get_reg_value(uint8_t reg, uint16_t page)
 {
     uint8_t value;
 
-    if (reg < 0x80)
+    if ((reg < 0x80) && (page == VSCP_NODE_PAGE))
+    {
+        value = vscp_get_reg_node_value(reg);
+    }
+    else if (reg < 0x80)
     {
         value = vscp_get_reg_msg_value(reg, page);
     }
@@ -725,7 +1053,11 @@ static uint8_t vscp_get_reg_value(uint8_t reg, uint16_t page)
 
 static void vscp_set_reg_value(uint8_t reg, uint16_t page, uint8_t value)
 {
-    if (reg < 0x80)
+    if ((reg < 0x80) && (page == VSCP_NODE_PAGE))
+    {
+        vscp_set_reg_node_value(reg, value);
+    }
+    else if (reg < 0x80)
     {
         vscp_set_reg_msg_value(reg, page, value);
     }
@@ -798,7 +1130,7 @@ static uint8_t vscp_get_reg_std_value(uint8_t reg)
         break;
 
     case VSCP_REG_NICKNAME_ID:
-        value = probe_nickname;
+        value = nickname;
         break;
 
     case VSCP_REG_PAGE_SELECT_MSB:
@@ -907,6 +1239,90 @@ static void vscp_set_reg_msg_value(uint8_t reg, uint16_t page, uint8_t value)
     message_callback_(&message);
 }
 
+// registers of the VSCP layer itself, on VSCP_NODE_PAGE
+// ------------------------------------------------------
+
+#define VSCP_NODE_REG_HEARTBEAT 0x00 // heartbeat period in s, 0 = 60s
+
+/* Diagnostics, read only. Reading the first register takes a snapshot of
+ * all of them so a single extended page read returns consistent values.
+ * Writing the first register clears the counters. Multi-byte values are
+ * MSB first.
+ *   0x10-0x13 CAN frames received
+ *   0x14-0x17 CAN frames sent
+ *   0x18-0x19 events which had to wait for a TX buffer
+ *   0x1A      CAN RX overflows
+ *   0x1B      times the controller went error-passive
+ *   0x1C      times the controller went bus-off
+ *   0x1D      TXERRCNT
+ *   0x1E      RXERRCNT
+ *   0x1F-0x20 longest main loop pass in ms
+ *   0x21-0x22 EEPROM bytes written since power up (not cleared)
+ */
+#define VSCP_NODE_REG_DIAG 0x10
+
+static uint8_t vscp_get_reg_node_value(uint8_t reg)
+{
+    uint8_t value = 0;
+
+    if (reg == VSCP_NODE_REG_DIAG)
+        vscp_diag_snapshot();
+    if ((reg >= VSCP_NODE_REG_DIAG) && (reg < VSCP_NODE_REG_DIAG + VSCP_DIAG_SIZE))
+        return diag[reg - VSCP_NODE_REG_DIAG];
+
+    switch (reg)
+    {
+    case VSCP_NODE_REG_HEARTBEAT:
+        vscp_get_msg_value(VSCP_MSG_HEARTBEAT, 0, &value);
+        break;
+    }
+    return value;
+}
+
+static void vscp_set_reg_node_value(uint8_t reg, uint8_t value)
+{
+    switch (reg)
+    {
+    case VSCP_NODE_REG_HEARTBEAT:
+        vscp_set_msg_value(VSCP_MSG_HEARTBEAT, 0, value);
+        heartbeat_period = value ? value : VSCP_HEARTBEAT_PERIOD;
+        break;
+
+    case VSCP_NODE_REG_DIAG:
+        can_clear_stats();
+        tx_retries = 0;
+        loop_max = 0;
+        break;
+    }
+}
+
+static void vscp_diag_snapshot(void)
+{
+    const can_stats_t * stats = can_get_stats();
+
+    diag[0] = (uint8_t) (stats->rx_frames >> 24);
+    diag[1] = (uint8_t) (stats->rx_frames >> 16);
+    diag[2] = (uint8_t) (stats->rx_frames >> 8);
+    diag[3] = (uint8_t) stats->rx_frames;
+    diag[4] = (uint8_t) (stats->tx_frames >> 24);
+    diag[5] = (uint8_t) (stats->tx_frames >> 16);
+    diag[6] = (uint8_t) (stats->tx_frames >> 8);
+    diag[7] = (uint8_t) stats->tx_frames;
+    diag[8] = (uint8_t) (tx_retries >> 8);
+    diag[9] = (uint8_t) tx_retries;
+    diag[10] = stats->rx_overflows;
+    diag[11] = stats->error_passive;
+    diag[12] = stats->bus_off;
+    diag[13] = can_tx_error_count();
+    diag[14] = can_rx_error_count();
+    diag[15] = (uint8_t) (loop_max >> 8);
+    diag[16] = (uint8_t) loop_max;
+    if (!vscp_get_msg_value(VSCP_MSG_EEPROM_WRITES, 0, &diag[17]))
+        diag[17] = 0;
+    if (!vscp_get_msg_value(VSCP_MSG_EEPROM_WRITES, 1, &diag[18]))
+        diag[18] = 0;
+}
+
 // helpers for exchanging messages with user applications
 // ------------------------------------------------------
 
@@ -977,6 +1393,16 @@ static uint8_t vscp_guid(uint8_t index)
     return value;
 }
 
+/* 16 bit hash of the GUID, seeds the per node spreading of bus traffic */
+static uint16_t vscp_guid_hash(void)
+{
+    uint16_t hash = 0;
+
+    for (uint8_t i = 0; i < 16; i++)
+        hash = ((hash << 3) | (hash >> 13)) ^ vscp_guid(i);
+    return hash;
+}
+
 static uint8_t vscp_mdf(uint8_t index)
 {
     uint8_t value;
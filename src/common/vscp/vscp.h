@@ -47,6 +47,10 @@ extern "C" {
 #define VSCP_MSG_STD_DEVICE          0x0C // FAMILY+SUBFAMILY
 #define VSCP_MSG_RESET_CONFIG        0x0D
 #define VSCP_MSG_PAGES_USED          0x0E
+#define VSCP_MSG_PUBLISH_STATE       0x0F // announced, send the full state
+#define VSCP_MSG_HEARTBEAT           0x10 // heartbeat period in s, 0 = default
+#define VSCP_MSG_CONFIG_CRC          0x11 // CRC-8 of the configuration
+#define VSCP_MSG_EEPROM_WRITES       0x12 // index 0 = MSB, 1 = LSB
     
     
     // Value for VSCP_MSG_SETSTATE 
@@ -55,6 +59,10 @@ extern "C" {
 #define VSCP_STATE_ACTIVE               0x02	// The normal state
 #define VSCP_STATE_ERROR                0x03	// error state. Big problems.
 
+    // Values for VSCP_MSG_BOOT_ALG
+#define VSCP_BOOTLOADER_PIC1            0x01	// Microchip PIC CAN bootloader
+#define VSCP_BOOTLOADER_NONE            0xFF
+
     // Values for priority
 #define VSCP_PRIORITY7                  0x00
 #define VSCP_PRIORITY_HIGH              0x00
@@ -69,9 +77,15 @@ extern "C" {
 #define VSCP_PRIORITY0                  0x07
 #define VSCP_PRIORITY_LOW               0x07
 
+    /* Page with the registers of the VSCP layer (heartbeat, diagnostics) */
+#define VSCP_NODE_PAGE                  0x0200
+
     /* Node nickname defines */
 #define VSCP_NICKNAME_FREE              0xFF
 #define VSCP_NICKNAME_MASTER            0x00
+    /* highest nickname a node takes by itself, the host tools scan 0..127
+     * and 0xFE is the nickname of a node in the bootloader */
+#define VSCP_NICKNAME_MAX               0x7F
 
 
 #define MAX_MSG_DATA_LENGTH 8
@@ -95,6 +109,7 @@ extern "C" {
             void event_callback(vscp_event_t * event)); // if set to 1, start in the init state!
 
     void vscp_send(vscp_event_t * event);
+    uint8_t vscp_get_nickname(void);
 
     void vscp_process(uint8_t init);
 
@@ -20,9 +20,9 @@ typedef struct {
     uint8_t vscp_event_off;
 }vscp4hass_bs_class_t;
     
-#define VSCP4HASS_BS_MAX_CLASS_ID 0x17
+#define VSCP4HASS_BS_MAX_CLASS_ID 0x18
     
-extern const vscp4hass_bs_class_t vscp4hass_bs_class_map[];
+extern const vscp4hass_bs_class_t vscp4hass_bs_class_map[VSCP4HASS_BS_MAX_CLASS_ID + 1];
 
 
 #ifdef	__cplusplus
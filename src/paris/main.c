@@ -14,6 +14,8 @@
 #include "swali.h"
 #include "discrete.h"
 #include "pic_swali.h"
+#include "pwm.h"
+#include "swali_config.h"
 
 #pragma config WDT = OFF
 #pragma config OSC = HSPLL
@@ -35,6 +37,17 @@
 // function declarations
 void init_platform(void);
 
+// output channels, in the order of discrete_write()
+const pwm_pin_t pwm_pins[SWALI_NUM_OUTPUTS] = {
+    {PWM_PORTB, 0x10}, // RB4
+    {PWM_PORTB, 0x02}, // RB1
+    {PWM_PORTB, 0x01}, // RB0
+    {PWM_PORTC, 0x80}, // RC7
+    {PWM_PORTC, 0x40}, // RC6
+    {PWM_PORTC, 0x20}, // RC5
+    {PWM_PORTC, 0x10}, // RC4
+};
+
 const uint8_t vscp_node_mdf[32] = "paris_z01";
 
 // function definitions
@@ -42,6 +55,7 @@ int main()
 {
     init_platform();
     systick_initialize();
+    pwm_init();
     time_init();
     led_init(GREEN_LED_ID);
     initialize_config_data();
@@ -52,6 +66,7 @@ int main()
     {
         vscp_process(process_button());
         swali_process();  
+        pwm_process();
     }
 }
 
@@ -99,12 +114,27 @@ void init_platform(void)
     TRISC = 0b00000001;
     PORTC = 0x00; // Default off
     
+    // The PWM timer gets the high priority interrupt, systick callbacks
+    // run in the low priority one so they don't delay the PWM edges
+    RCONbits.IPEN = 1;
+    INTCON2bits.TMR0IP = 0;
+
     // Enable interrupts
     ei();
+    INTCONbits.GIEL = 1;
 
 }
 
 void interrupt interrupt_service(void)
+{
+    if (PIR1bits.TMR1IF)
+    {
+        pwm_service();
+        PIR1bits.TMR1IF = 0; // Clear Timer1 Interrupt Flag
+    }
+}
+
+void interrupt low_priority interrupt_low_service(void)
 {
     if (INTCONbits.TMR0IF)
     {
@@ -133,28 +163,28 @@ void discrete_write(uint8_t id, uint8_t value)
     switch (id)
     {
     case 0:
-        PORTBbits.RB4 = value;
+        LATBbits.LATB4 = value;
         break;
     case 1:
-        PORTBbits.RB1 = value;
+        LATBbits.LATB1 = value;
         break;
     case 2:
-        PORTBbits.RB0 = value;
+        LATBbits.LATB0 = value;
         break;
     case 3:
-        PORTCbits.RC7 = value;
+        LATCbits.LATC7 = value;
         break;
     case 4:
-        PORTCbits.RC6 = value;
+        LATCbits.LATC6 = value;
         break;
     case 5:
-        PORTCbits.RC5 = value;
+        LATCbits.LATC5 = value;
         break;
     case 6:
-        PORTCbits.RC4 = value;
+        LATCbits.LATC4 = value;
         break;
     case GREEN_LED_ID: // Green LED
-        PORTCbits.RC1 = value;
+        LATCbits.LATC1 = value;
         break;
     }
 }
\ No newline at end of file
@@ -8,6 +8,8 @@ extern "C" {
 #define SWALI_NUM_INPUTS 0
 #define SWALI_NUM_OUTPUTS 7
 #define SWALI_NAME_LENGTH 16 // number of characters to store for outputs
+#define SWALI_NUM_SCENES 8   // scene table entries, each takes 4 bytes
+#define SWALI_NUM_DM_ROWS 4  // decision matrix rows, each takes 8 bytes
 
 #ifdef	__cplusplus
 }